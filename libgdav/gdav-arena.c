@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#include "config.h"
+
+#include "gdav-arena.h"
+
+/* Size of each block in the string chunk. */
+#define ARENA_BLOCK_SIZE 65536
+
+struct _GDavArena {
+	GStringChunk *chunk;
+	volatile gint ref_count;
+};
+
+static GPrivate thread_default_arenas = G_PRIVATE_INIT (
+	(GDestroyNotify) g_queue_free);
+
+GDavArena *
+gdav_arena_new (void)
+{
+	GDavArena *arena;
+
+	arena = g_slice_new0 (GDavArena);
+	arena->chunk = g_string_chunk_new (ARENA_BLOCK_SIZE);
+	arena->ref_count = 1;
+
+	return arena;
+}
+
+GDavArena *
+gdav_arena_ref (GDavArena *arena)
+{
+	g_return_val_if_fail (arena != NULL, NULL);
+	g_return_val_if_fail (arena->ref_count > 0, NULL);
+
+	g_atomic_int_inc (&arena->ref_count);
+
+	return arena;
+}
+
+void
+gdav_arena_unref (GDavArena *arena)
+{
+	g_return_if_fail (arena != NULL);
+	g_return_if_fail (arena->ref_count > 0);
+
+	if (g_atomic_int_dec_and_test (&arena->ref_count)) {
+		g_string_chunk_free (arena->chunk);
+		g_slice_free (GDavArena, arena);
+	}
+}
+
+const gchar *
+gdav_arena_strdup (GDavArena *arena,
+                   const gchar *string)
+{
+	g_return_val_if_fail (arena != NULL, NULL);
+
+	if (string == NULL)
+		return NULL;
+
+	return g_string_chunk_insert (arena->chunk, string);
+}
+
+void
+gdav_arena_push_thread_default (GDavArena *arena)
+{
+	GQueue *queue;
+
+	g_return_if_fail (arena != NULL);
+
+	queue = g_private_get (&thread_default_arenas);
+
+	if (queue == NULL) {
+		queue = g_queue_new ();
+		g_private_set (&thread_default_arenas, queue);
+	}
+
+	g_queue_push_head (queue, arena);
+}
+
+void
+gdav_arena_pop_thread_default (GDavArena *arena)
+{
+	GQueue *queue;
+
+	g_return_if_fail (arena != NULL);
+
+	queue = g_private_get (&thread_default_arenas);
+
+	g_return_if_fail (queue != NULL);
+	g_return_if_fail (g_queue_peek_head (queue) == arena);
+
+	g_queue_pop_head (queue);
+}
+
+/* Returns the innermost arena pushed by this thread, or NULL.
+ * Deserializers use this to find the arena for the result they
+ * are building without it being passed down explicitly. */
+GDavArena *
+gdav_arena_get_thread_default (void)
+{
+	GQueue *queue;
+
+	queue = g_private_get (&thread_default_arenas);
+
+	if (queue == NULL)
+		return NULL;
+
+	return g_queue_peek_head (queue);
+}
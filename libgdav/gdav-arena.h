@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_ARENA_H__
+#define __GDAV_ARENA_H__
+
+/* This is a private header, not installed. */
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/* A reference-counted block allocator for strings that live as
+ * long as a parsed result.  Strings are never freed individually;
+ * all of them go away together when the last reference is dropped.
+ * Not thread-safe: only the thread that owns it may add strings. */
+typedef struct _GDavArena GDavArena;
+
+GDavArena *	gdav_arena_new			(void);
+GDavArena *	gdav_arena_ref			(GDavArena *arena);
+void		gdav_arena_unref		(GDavArena *arena);
+const gchar *	gdav_arena_strdup		(GDavArena *arena,
+						 const gchar *string);
+void		gdav_arena_push_thread_default	(GDavArena *arena);
+void		gdav_arena_pop_thread_default	(GDavArena *arena);
+GDavArena *	gdav_arena_get_thread_default	(void);
+
+G_END_DECLS
+
+#endif /* __GDAV_ARENA_H__ */
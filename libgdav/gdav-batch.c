@@ -0,0 +1,1150 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#include "config.h"
+
+#include "gdav-batch.h"
+
+#include <glib/gi18n-lib.h>
+
+#include "gdav-utils.h"
+
+#define GDAV_BATCH_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), GDAV_TYPE_BATCH, GDavBatchPrivate))
+
+typedef struct _BatchHost BatchHost;
+typedef struct _BatchOp BatchOp;
+
+typedef enum {
+	BATCH_OP_PROPFIND,
+	BATCH_OP_PROPPATCH,
+	BATCH_OP_MKCOL,
+	BATCH_OP_PUT,
+	BATCH_OP_DELETE,
+	BATCH_OP_COPY,
+	BATCH_OP_MOVE
+} BatchOpKind;
+
+typedef enum {
+	BATCH_OP_WAITING,
+	BATCH_OP_RUNNING,
+	BATCH_OP_DONE
+} BatchOpState;
+
+struct _BatchHost {
+	/* Operations with no outstanding prerequisites,
+	 * in the order they were added to the batch. */
+	GQueue ready;
+	guint n_running;
+};
+
+struct _BatchOp {
+	GDavBatch *batch;
+	BatchHost *host;
+	guint id;
+	BatchOpKind kind;
+	BatchOpState state;
+	gboolean queued;
+	gboolean failed;
+
+	SoupURI *uri;
+	GDavPropFindType propfind_type;
+	GDavPropertySet *prop;
+	GDavPropertyUpdate *update;
+	GDavDepth depth;
+	gchar *destination;
+	guint flags;
+	GFile *file;
+	gchar *content_type;
+	gchar *if_match;
+
+	guint n_prerequisites;
+	GPtrArray *dependents;
+};
+
+struct _GDavBatchPrivate {
+	SoupSession *session;
+	guint max_concurrent;
+	guint max_per_host;
+	GDavBatchPolicy policy;
+
+	GDavBatchFunc func;
+	gpointer func_data;
+	GDestroyNotify func_notify;
+
+	/* Operation IDs start at 1, so ops[id - 1]. */
+	GPtrArray *ops;
+
+	/* "host:port" -> BatchHost */
+	GHashTable *hosts;
+
+	guint n_running;
+	guint n_done;
+	gboolean aborted;
+
+	/* These are only set while the batch is running. */
+	GTask *task;
+	GCancellable *cancellable;
+	gulong cancelled_handler_id;
+	GError *error;
+};
+
+enum {
+	PROP_0,
+	PROP_MAX_CONCURRENT,
+	PROP_MAX_PER_HOST,
+	PROP_POLICY,
+	PROP_SESSION
+};
+
+G_DEFINE_TYPE (GDavBatch, gdav_batch, G_TYPE_OBJECT)
+
+static void	gdav_batch_op_finished		(GDavBatch *batch,
+						 BatchOp *op,
+						 GDavMultiStatus *multi_status,
+						 const GError *error);
+static void	gdav_batch_dispatch		(GDavBatch *batch);
+
+static void
+batch_host_free (BatchHost *host)
+{
+	g_queue_clear (&host->ready);
+
+	g_slice_free (BatchHost, host);
+}
+
+static void
+batch_op_free (BatchOp *op)
+{
+	soup_uri_free (op->uri);
+	g_clear_object (&op->prop);
+	g_clear_object (&op->update);
+	g_free (op->destination);
+	g_clear_object (&op->file);
+	g_free (op->content_type);
+	g_free (op->if_match);
+	g_ptr_array_free (op->dependents, TRUE);
+
+	g_slice_free (BatchOp, op);
+}
+
+static BatchOp *
+gdav_batch_lookup_op (GDavBatch *batch,
+                      guint op_id)
+{
+	if (op_id == 0 || op_id > batch->priv->ops->len)
+		return NULL;
+
+	return g_ptr_array_index (batch->priv->ops, op_id - 1);
+}
+
+static void
+gdav_batch_enqueue_op (GDavBatch *batch,
+                       BatchOp *op)
+{
+	g_queue_push_tail (&op->host->ready, op);
+	op->queued = TRUE;
+}
+
+static void
+gdav_batch_dequeue_op (GDavBatch *batch,
+                       BatchOp *op)
+{
+	if (op->queued) {
+		g_queue_remove (&op->host->ready, op);
+		op->queued = FALSE;
+	}
+}
+
+static guint
+gdav_batch_add_op (GDavBatch *batch,
+                   BatchOpKind kind,
+                   SoupURI *uri)
+{
+	BatchOp *op;
+	BatchHost *host;
+	gchar *host_key;
+
+	host_key = g_strdup_printf (
+		"%s:%u",
+		soup_uri_get_host (uri),
+		soup_uri_get_port (uri));
+
+	host = g_hash_table_lookup (batch->priv->hosts, host_key);
+
+	if (host == NULL) {
+		host = g_slice_new0 (BatchHost);
+		g_queue_init (&host->ready);
+		g_hash_table_insert (batch->priv->hosts, host_key, host);
+	} else {
+		g_free (host_key);
+	}
+
+	op = g_slice_new0 (BatchOp);
+	op->batch = batch;
+	op->host = host;
+	op->kind = kind;
+	op->state = BATCH_OP_WAITING;
+	op->uri = soup_uri_copy (uri);
+	op->dependents = g_ptr_array_new ();
+
+	g_ptr_array_add (batch->priv->ops, op);
+	op->id = batch->priv->ops->len;
+
+	/* Operations added while the batch is running
+	 * are picked up on the next dispatch. */
+	gdav_batch_enqueue_op (batch, op);
+
+	return op->id;
+}
+
+static void
+gdav_batch_report (GDavBatch *batch,
+                   BatchOp *op,
+                   GDavMultiStatus *multi_status,
+                   const GError *error)
+{
+	op->state = BATCH_OP_DONE;
+	op->failed = (error != NULL);
+	batch->priv->n_done++;
+
+	if (error != NULL && batch->priv->error == NULL)
+		batch->priv->error = g_error_copy (error);
+
+	if (batch->priv->func != NULL)
+		batch->priv->func (
+			batch, op->id, multi_status,
+			error, batch->priv->func_data);
+}
+
+static void
+gdav_batch_abort (GDavBatch *batch,
+                  const GError *error)
+{
+	GHashTableIter iter;
+	gpointer value;
+	guint ii;
+
+	if (batch->priv->aborted)
+		return;
+
+	batch->priv->aborted = TRUE;
+
+	g_hash_table_iter_init (&iter, batch->priv->hosts);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		BatchHost *host = value;
+		g_queue_clear (&host->ready);
+	}
+
+	for (ii = 0; ii < batch->priv->ops->len; ii++) {
+		BatchOp *op;
+
+		op = g_ptr_array_index (batch->priv->ops, ii);
+		op->queued = FALSE;
+
+		if (op->state == BATCH_OP_WAITING)
+			gdav_batch_report (batch, op, NULL, error);
+	}
+
+	/* Do this last, since cancelling can complete
+	 * in-flight operations before returning. */
+	if (batch->priv->cancellable != NULL)
+		g_cancellable_cancel (batch->priv->cancellable);
+}
+
+static void
+gdav_batch_skip_op (GDavBatch *batch,
+                    BatchOp *op,
+                    BatchOp *prerequisite)
+{
+	GError *local_error;
+
+	local_error = g_error_new (
+		G_IO_ERROR, G_IO_ERROR_CANCELLED,
+		_("Skipped because operation %u failed"),
+		prerequisite->id);
+
+	gdav_batch_dequeue_op (batch, op);
+	gdav_batch_op_finished (batch, op, NULL, local_error);
+
+	g_error_free (local_error);
+}
+
+static void
+gdav_batch_op_finished (GDavBatch *batch,
+                        BatchOp *op,
+                        GDavMultiStatus *multi_status,
+                        const GError *error)
+{
+	guint ii;
+
+	gdav_batch_report (batch, op, multi_status, error);
+
+	if (error != NULL && batch->priv->policy == GDAV_BATCH_POLICY_FAIL_FAST) {
+		GError *local_error;
+
+		local_error = g_error_new_literal (
+			G_IO_ERROR, G_IO_ERROR_CANCELLED,
+			_("Skipped because an earlier operation failed"));
+		gdav_batch_abort (batch, local_error);
+		g_error_free (local_error);
+	}
+
+	if (batch->priv->aborted)
+		return;
+
+	for (ii = 0; ii < op->dependents->len; ii++) {
+		BatchOp *dependent;
+
+		dependent = g_ptr_array_index (op->dependents, ii);
+		dependent->n_prerequisites--;
+
+		if (dependent->state != BATCH_OP_WAITING)
+			continue;
+
+		if (op->failed)
+			gdav_batch_skip_op (batch, dependent, op);
+		else if (dependent->n_prerequisites == 0)
+			gdav_batch_enqueue_op (batch, dependent);
+	}
+}
+
+static void
+gdav_batch_op_done_cb (GObject *source_object,
+                       GAsyncResult *result,
+                       gpointer user_data)
+{
+	SoupSession *session;
+	GDavBatch *batch;
+	GDavMultiStatus *multi_status = NULL;
+	BatchOp *op = user_data;
+	GError *local_error = NULL;
+
+	session = SOUP_SESSION (source_object);
+
+	/* Finishing an operation can complete the batch,
+	 * so keep it alive until we're done with it. */
+	batch = g_object_ref (op->batch);
+
+	switch (op->kind) {
+		case BATCH_OP_PROPFIND:
+			multi_status = gdav_propfind_finish (
+				session, result, NULL, &local_error);
+			break;
+		case BATCH_OP_PROPPATCH:
+			multi_status = gdav_proppatch_finish (
+				session, result, NULL, &local_error);
+			break;
+		case BATCH_OP_MKCOL:
+			gdav_mkcol_finish (
+				session, result, NULL, &local_error);
+			break;
+		case BATCH_OP_PUT:
+			gdav_put_finish (
+				session, result, NULL, NULL, &local_error);
+			break;
+		case BATCH_OP_DELETE:
+			gdav_delete_finish (
+				session, result, &multi_status,
+				NULL, &local_error);
+			break;
+		case BATCH_OP_COPY:
+			gdav_copy_finish (
+				session, result, &multi_status,
+				NULL, &local_error);
+			break;
+		case BATCH_OP_MOVE:
+			gdav_move_finish (
+				session, result, &multi_status,
+				NULL, &local_error);
+			break;
+	}
+
+	op->host->n_running--;
+	batch->priv->n_running--;
+
+	gdav_batch_op_finished (batch, op, multi_status, local_error);
+
+	g_clear_object (&multi_status);
+	g_clear_error (&local_error);
+
+	gdav_batch_dispatch (batch);
+
+	g_object_unref (batch);
+}
+
+static void
+gdav_batch_op_start (GDavBatch *batch,
+                     BatchOp *op)
+{
+	SoupSession *session = batch->priv->session;
+	GCancellable *cancellable = batch->priv->cancellable;
+
+	op->state = BATCH_OP_RUNNING;
+	op->host->n_running++;
+	batch->priv->n_running++;
+
+	switch (op->kind) {
+		case BATCH_OP_PROPFIND:
+			gdav_propfind (
+				session, op->uri, op->propfind_type,
+				op->prop, op->depth, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+		case BATCH_OP_PROPPATCH:
+			gdav_proppatch (
+				session, op->uri, op->update, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+		case BATCH_OP_MKCOL:
+			gdav_mkcol (
+				session, op->uri, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+		case BATCH_OP_PUT:
+			gdav_put_file (
+				session, op->uri, op->file,
+				op->content_type, op->if_match,
+				op->flags, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+		case BATCH_OP_DELETE:
+			gdav_delete (
+				session, op->uri, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+		case BATCH_OP_COPY:
+			gdav_copy (
+				session, op->uri, op->destination,
+				op->flags, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+		case BATCH_OP_MOVE:
+			gdav_move (
+				session, op->uri, op->destination,
+				op->flags, cancellable,
+				gdav_batch_op_done_cb, op);
+			break;
+	}
+}
+
+static BatchOp *
+gdav_batch_next_op (GDavBatch *batch)
+{
+	GHashTableIter iter;
+	BatchHost *next_host = NULL;
+	BatchOp *next_op = NULL;
+	gpointer value;
+
+	/* Pick the earliest ready operation on a host that is
+	 * below its limit.  There are rarely more than a few
+	 * hosts, so a linear scan is fine. */
+
+	g_hash_table_iter_init (&iter, batch->priv->hosts);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		BatchHost *host = value;
+		BatchOp *op;
+
+		if (host->n_running >= batch->priv->max_per_host)
+			continue;
+
+		op = g_queue_peek_head (&host->ready);
+
+		if (op == NULL)
+			continue;
+
+		if (next_op == NULL || op->id < next_op->id) {
+			next_host = host;
+			next_op = op;
+		}
+	}
+
+	if (next_op != NULL) {
+		g_queue_pop_head (&next_host->ready);
+		next_op->queued = FALSE;
+	}
+
+	return next_op;
+}
+
+static void
+gdav_batch_complete (GDavBatch *batch)
+{
+	GCancellable *cancellable;
+	GTask *task;
+
+	task = batch->priv->task;
+	batch->priv->task = NULL;
+
+	cancellable = g_task_get_cancellable (task);
+
+	/* XXX g_cancellable_disconnect() deadlocks if we got
+	 *     here from within the "cancelled" signal emission,
+	 *     which is possible if cancelling an operation
+	 *     finishes it synchronously. */
+	if (batch->priv->cancelled_handler_id > 0)
+		g_signal_handler_disconnect (
+			cancellable, batch->priv->cancelled_handler_id);
+	batch->priv->cancelled_handler_id = 0;
+
+	g_clear_object (&batch->priv->cancellable);
+
+	if (batch->priv->error != NULL) {
+		g_task_return_error (task, batch->priv->error);
+		batch->priv->error = NULL;
+	} else {
+		g_task_return_boolean (task, TRUE);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+gdav_batch_dispatch (GDavBatch *batch)
+{
+	GError *local_error = NULL;
+
+	/* Sanity check */
+	if (batch->priv->task == NULL)
+		return;
+
+	if (g_cancellable_set_error_if_cancelled (
+		batch->priv->cancellable, &local_error)) {
+		gdav_batch_abort (batch, local_error);
+		g_error_free (local_error);
+	}
+
+	while (batch->priv->n_running < batch->priv->max_concurrent) {
+		BatchOp *op;
+
+		op = gdav_batch_next_op (batch);
+
+		if (op == NULL)
+			break;
+
+		gdav_batch_op_start (batch, op);
+	}
+
+	if (batch->priv->task == NULL)
+		return;
+
+	if (batch->priv->n_running == 0 &&
+	    batch->priv->n_done == batch->priv->ops->len)
+		gdav_batch_complete (batch);
+}
+
+static void
+gdav_batch_cancelled_cb (GCancellable *cancellable,
+                         GCancellable *batch_cancellable)
+{
+	g_cancellable_cancel (batch_cancellable);
+}
+
+static void
+gdav_batch_set_session (GDavBatch *batch,
+                        SoupSession *session)
+{
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (batch->priv->session == NULL);
+
+	batch->priv->session = g_object_ref (session);
+}
+
+static void
+gdav_batch_set_property (GObject *object,
+                         guint property_id,
+                         const GValue *value,
+                         GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_MAX_CONCURRENT:
+			gdav_batch_set_max_concurrent (
+				GDAV_BATCH (object),
+				g_value_get_uint (value));
+			return;
+
+		case PROP_MAX_PER_HOST:
+			gdav_batch_set_max_per_host (
+				GDAV_BATCH (object),
+				g_value_get_uint (value));
+			return;
+
+		case PROP_POLICY:
+			gdav_batch_set_policy (
+				GDAV_BATCH (object),
+				g_value_get_enum (value));
+			return;
+
+		case PROP_SESSION:
+			gdav_batch_set_session (
+				GDAV_BATCH (object),
+				g_value_get_object (value));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+gdav_batch_get_property (GObject *object,
+                         guint property_id,
+                         GValue *value,
+                         GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_MAX_CONCURRENT:
+			g_value_set_uint (
+				value,
+				gdav_batch_get_max_concurrent (
+				GDAV_BATCH (object)));
+			return;
+
+		case PROP_MAX_PER_HOST:
+			g_value_set_uint (
+				value,
+				gdav_batch_get_max_per_host (
+				GDAV_BATCH (object)));
+			return;
+
+		case PROP_POLICY:
+			g_value_set_enum (
+				value,
+				gdav_batch_get_policy (
+				GDAV_BATCH (object)));
+			return;
+
+		case PROP_SESSION:
+			g_value_set_object (
+				value,
+				gdav_batch_get_session (
+				GDAV_BATCH (object)));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+gdav_batch_dispose (GObject *object)
+{
+	GDavBatchPrivate *priv;
+
+	priv = GDAV_BATCH_GET_PRIVATE (object);
+
+	g_clear_object (&priv->session);
+
+	/* Chain up to parent's dispose() method. */
+	G_OBJECT_CLASS (gdav_batch_parent_class)->dispose (object);
+}
+
+static void
+gdav_batch_finalize (GObject *object)
+{
+	GDavBatchPrivate *priv;
+
+	priv = GDAV_BATCH_GET_PRIVATE (object);
+
+	if (priv->func_notify != NULL)
+		priv->func_notify (priv->func_data);
+
+	g_ptr_array_free (priv->ops, TRUE);
+	g_hash_table_destroy (priv->hosts);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (gdav_batch_parent_class)->finalize (object);
+}
+
+static void
+gdav_batch_class_init (GDavBatchClass *class)
+{
+	GObjectClass *object_class;
+
+	g_type_class_add_private (class, sizeof (GDavBatchPrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->set_property = gdav_batch_set_property;
+	object_class->get_property = gdav_batch_get_property;
+	object_class->dispose = gdav_batch_dispose;
+	object_class->finalize = gdav_batch_finalize;
+
+	/* Note that SoupSession applies its own "max-conns" and
+	 * "max-conns-per-host" limits underneath these, so raise
+	 * those too or requests will just queue in the session. */
+
+	g_object_class_install_property (
+		object_class,
+		PROP_MAX_CONCURRENT,
+		g_param_spec_uint (
+			"max-concurrent",
+			"Max Concurrent",
+			"Maximum number of operations in flight",
+			1,
+			G_MAXUINT,
+			8,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_MAX_PER_HOST,
+		g_param_spec_uint (
+			"max-per-host",
+			"Max Per Host",
+			"Maximum number of operations in flight per host",
+			1,
+			G_MAXUINT,
+			4,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_POLICY,
+		g_param_spec_enum (
+			"policy",
+			"Policy",
+			"What to do when an operation fails",
+			GDAV_TYPE_BATCH_POLICY,
+			GDAV_BATCH_POLICY_FAIL_FAST,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_SESSION,
+		g_param_spec_object (
+			"session",
+			"Session",
+			"The session on which to send requests",
+			SOUP_TYPE_SESSION,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT_ONLY |
+			G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdav_batch_init (GDavBatch *batch)
+{
+	batch->priv = GDAV_BATCH_GET_PRIVATE (batch);
+
+	batch->priv->ops = g_ptr_array_new_with_free_func (
+		(GDestroyNotify) batch_op_free);
+
+	batch->priv->hosts = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) batch_host_free);
+}
+
+GDavBatch *
+gdav_batch_new (SoupSession *session)
+{
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+
+	return g_object_new (GDAV_TYPE_BATCH, "session", session, NULL);
+}
+
+SoupSession *
+gdav_batch_get_session (GDavBatch *batch)
+{
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), NULL);
+
+	return batch->priv->session;
+}
+
+guint
+gdav_batch_get_max_concurrent (GDavBatch *batch)
+{
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+
+	return batch->priv->max_concurrent;
+}
+
+void
+gdav_batch_set_max_concurrent (GDavBatch *batch,
+                               guint max_concurrent)
+{
+	g_return_if_fail (GDAV_IS_BATCH (batch));
+	g_return_if_fail (max_concurrent > 0);
+
+	if (max_concurrent != batch->priv->max_concurrent) {
+		batch->priv->max_concurrent = max_concurrent;
+		g_object_notify (G_OBJECT (batch), "max-concurrent");
+	}
+}
+
+guint
+gdav_batch_get_max_per_host (GDavBatch *batch)
+{
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+
+	return batch->priv->max_per_host;
+}
+
+void
+gdav_batch_set_max_per_host (GDavBatch *batch,
+                             guint max_per_host)
+{
+	g_return_if_fail (GDAV_IS_BATCH (batch));
+	g_return_if_fail (max_per_host > 0);
+
+	if (max_per_host != batch->priv->max_per_host) {
+		batch->priv->max_per_host = max_per_host;
+		g_object_notify (G_OBJECT (batch), "max-per-host");
+	}
+}
+
+GDavBatchPolicy
+gdav_batch_get_policy (GDavBatch *batch)
+{
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+
+	return batch->priv->policy;
+}
+
+void
+gdav_batch_set_policy (GDavBatch *batch,
+                       GDavBatchPolicy policy)
+{
+	g_return_if_fail (GDAV_IS_BATCH (batch));
+
+	if (policy != batch->priv->policy) {
+		batch->priv->policy = policy;
+		g_object_notify (G_OBJECT (batch), "policy");
+	}
+}
+
+/**
+ * gdav_batch_set_func:
+ * @batch: a #GDavBatch
+ * @func: a #GDavBatchFunc, or %NULL
+ * @user_data: user data to pass to @func
+ * @notify: a #GDestroyNotify for @user_data, or %NULL
+ *
+ * Sets a function to be called as each operation in @batch completes,
+ * fails or is skipped.  New operations may be added from @func.
+ **/
+void
+gdav_batch_set_func (GDavBatch *batch,
+                     GDavBatchFunc func,
+                     gpointer user_data,
+                     GDestroyNotify notify)
+{
+	g_return_if_fail (GDAV_IS_BATCH (batch));
+
+	if (batch->priv->func_notify != NULL)
+		batch->priv->func_notify (batch->priv->func_data);
+
+	batch->priv->func = func;
+	batch->priv->func_data = user_data;
+	batch->priv->func_notify = notify;
+}
+
+guint
+gdav_batch_add_propfind (GDavBatch *batch,
+                         SoupURI *uri,
+                         GDavPropFindType type,
+                         GDavPropertySet *prop,
+                         GDavDepth depth)
+{
+	BatchOp *op;
+	guint op_id;
+
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+
+	if (type == GDAV_PROPFIND_PROP)
+		g_return_val_if_fail (GDAV_IS_PROPERTY_SET (prop), 0);
+
+	op_id = gdav_batch_add_op (batch, BATCH_OP_PROPFIND, uri);
+
+	op = gdav_batch_lookup_op (batch, op_id);
+	op->propfind_type = type;
+	op->depth = depth;
+
+	if (prop != NULL)
+		op->prop = g_object_ref (prop);
+
+	return op_id;
+}
+
+guint
+gdav_batch_add_proppatch (GDavBatch *batch,
+                          SoupURI *uri,
+                          GDavPropertyUpdate *update)
+{
+	BatchOp *op;
+	guint op_id;
+
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+	g_return_val_if_fail (GDAV_IS_PROPERTY_UPDATE (update), 0);
+
+	op_id = gdav_batch_add_op (batch, BATCH_OP_PROPPATCH, uri);
+
+	op = gdav_batch_lookup_op (batch, op_id);
+	op->update = g_object_ref (update);
+
+	return op_id;
+}
+
+guint
+gdav_batch_add_mkcol (GDavBatch *batch,
+                      SoupURI *uri)
+{
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+
+	return gdav_batch_add_op (batch, BATCH_OP_MKCOL, uri);
+}
+
+/**
+ * gdav_batch_add_put:
+ * @batch: a #GDavBatch
+ * @uri: a #SoupURI
+ * @file: a #GFile to upload
+ * @content_type: the MIME type of @file, or %NULL
+ * @if_match: an entity tag the resource must match, or %NULL
+ * @flags: #GDavPutFlags
+ *
+ * Adds an upload of @file to @uri, as with gdav_put_file().  @file is
+ * only opened when the operation starts, so a batch can hold many
+ * uploads without holding many open files.  To upload into a new
+ * collection, make the PUT depend on its MKCOL with
+ * gdav_batch_add_dependency().
+ *
+ * Returns: an operation ID
+ **/
+guint
+gdav_batch_add_put (GDavBatch *batch,
+                    SoupURI *uri,
+                    GFile *file,
+                    const gchar *content_type,
+                    const gchar *if_match,
+                    GDavPutFlags flags)
+{
+	BatchOp *op;
+	guint op_id;
+
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+	g_return_val_if_fail (G_IS_FILE (file), 0);
+
+	op_id = gdav_batch_add_op (batch, BATCH_OP_PUT, uri);
+
+	op = gdav_batch_lookup_op (batch, op_id);
+	op->file = g_object_ref (file);
+	op->content_type = g_strdup (content_type);
+	op->if_match = g_strdup (if_match);
+	op->flags = flags;
+
+	return op_id;
+}
+
+guint
+gdav_batch_add_delete (GDavBatch *batch,
+                       SoupURI *uri)
+{
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+
+	return gdav_batch_add_op (batch, BATCH_OP_DELETE, uri);
+}
+
+guint
+gdav_batch_add_copy (GDavBatch *batch,
+                     SoupURI *uri,
+                     const gchar *destination,
+                     GDavCopyFlags flags)
+{
+	BatchOp *op;
+	guint op_id;
+
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+	g_return_val_if_fail (destination != NULL, 0);
+
+	op_id = gdav_batch_add_op (batch, BATCH_OP_COPY, uri);
+
+	op = gdav_batch_lookup_op (batch, op_id);
+	op->destination = g_strdup (destination);
+	op->flags = flags;
+
+	return op_id;
+}
+
+guint
+gdav_batch_add_move (GDavBatch *batch,
+                     SoupURI *uri,
+                     const gchar *destination,
+                     GDavMoveFlags flags)
+{
+	BatchOp *op;
+	guint op_id;
+
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), 0);
+	g_return_val_if_fail (uri != NULL, 0);
+	g_return_val_if_fail (destination != NULL, 0);
+
+	op_id = gdav_batch_add_op (batch, BATCH_OP_MOVE, uri);
+
+	op = gdav_batch_lookup_op (batch, op_id);
+	op->destination = g_strdup (destination);
+	op->flags = flags;
+
+	return op_id;
+}
+
+/**
+ * gdav_batch_add_dependency:
+ * @batch: a #GDavBatch
+ * @op_id: an operation ID
+ * @prerequisite_id: the ID of an operation added before @op_id
+ *
+ * Holds back @op_id until @prerequisite_id has completed.  If
+ * @prerequisite_id fails, @op_id is skipped and reported with a
+ * %G_IO_ERROR_CANCELLED error.
+ *
+ * Requiring the prerequisite to be added first rules out cycles.
+ **/
+void
+gdav_batch_add_dependency (GDavBatch *batch,
+                           guint op_id,
+                           guint prerequisite_id)
+{
+	BatchOp *op;
+	BatchOp *prerequisite;
+
+	g_return_if_fail (GDAV_IS_BATCH (batch));
+	g_return_if_fail (prerequisite_id < op_id);
+
+	op = gdav_batch_lookup_op (batch, op_id);
+	prerequisite = gdav_batch_lookup_op (batch, prerequisite_id);
+
+	g_return_if_fail (op != NULL);
+	g_return_if_fail (prerequisite != NULL);
+	g_return_if_fail (op->state == BATCH_OP_WAITING);
+
+	if (prerequisite->state != BATCH_OP_DONE) {
+		g_ptr_array_add (prerequisite->dependents, op);
+		op->n_prerequisites++;
+		gdav_batch_dequeue_op (batch, op);
+	} else if (prerequisite->failed) {
+		gdav_batch_skip_op (batch, op, prerequisite);
+	}
+}
+
+gboolean
+gdav_batch_run_sync (GDavBatch *batch,
+                     GCancellable *cancellable,
+                     GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (GDAV_IS_BATCH (batch), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_batch_run (
+		batch, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_batch_run_finish (batch, result, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+/**
+ * gdav_batch_run:
+ * @batch: a #GDavBatch
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the batch is done
+ * @user_data: data to pass to the callback function
+ *
+ * Starts the operations in @batch, keeping at most #GDavBatch:max-concurrent
+ * in flight overall and at most #GDavBatch:max-per-host in flight to any
+ * one host.  @callback is called once every operation has completed or
+ * been skipped.
+ **/
+void
+gdav_batch_run (GDavBatch *batch,
+                GCancellable *cancellable,
+                GAsyncReadyCallback callback,
+                gpointer user_data)
+{
+	g_return_if_fail (GDAV_IS_BATCH (batch));
+	g_return_if_fail (batch->priv->task == NULL);
+
+	batch->priv->task = g_task_new (
+		batch, cancellable, callback, user_data);
+	g_task_set_source_tag (batch->priv->task, gdav_batch_run);
+
+	batch->priv->cancellable = g_cancellable_new ();
+	batch->priv->aborted = FALSE;
+
+	if (cancellable != NULL)
+		batch->priv->cancelled_handler_id = g_cancellable_connect (
+			cancellable,
+			G_CALLBACK (gdav_batch_cancelled_cb),
+			g_object_ref (batch->priv->cancellable),
+			(GDestroyNotify) g_object_unref);
+
+	gdav_batch_dispatch (batch);
+}
+
+/**
+ * gdav_batch_run_finish:
+ * @batch: a #GDavBatch
+ * @result: a #GAsyncResult
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes an operation started with gdav_batch_run().  If any
+ * operation in the batch failed, sets @error to the first failure
+ * and returns %FALSE.  Individual results are delivered through the
+ * function set with gdav_batch_set_func().
+ *
+ * Returns: %TRUE if every operation succeeded, %FALSE otherwise
+ **/
+gboolean
+gdav_batch_run_finish (GDavBatch *batch,
+                       GAsyncResult *result,
+                       GError **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, batch), FALSE);
+
+	g_return_val_if_fail (
+		g_async_result_is_tagged (
+		result, gdav_batch_run), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
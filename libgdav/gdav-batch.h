@@ -0,0 +1,143 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_BATCH_H__
+#define __GDAV_BATCH_H__
+
+#include <libgdav/gdav-methods.h>
+
+/* Standard GObject macros */
+#define GDAV_TYPE_BATCH \
+	(gdav_batch_get_type ())
+#define GDAV_BATCH(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST \
+	((obj), GDAV_TYPE_BATCH, GDavBatch))
+#define GDAV_BATCH_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_CAST \
+	((cls), GDAV_TYPE_BATCH, GDavBatchClass))
+#define GDAV_IS_BATCH(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE \
+	((obj), GDAV_TYPE_BATCH))
+#define GDAV_IS_BATCH_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_TYPE \
+	((cls), GDAV_TYPE_BATCH))
+#define GDAV_BATCH_GET_CLASS(obj) \
+	(G_TYPE_INSTANCE_GET_CLASS \
+	((obj), GDAV_TYPE_BATCH, GDavBatchClass))
+
+G_BEGIN_DECLS
+
+typedef struct _GDavBatch GDavBatch;
+typedef struct _GDavBatchClass GDavBatchClass;
+typedef struct _GDavBatchPrivate GDavBatchPrivate;
+
+/**
+ * GDavBatchFunc:
+ * @batch: a #GDavBatch
+ * @op_id: the operation ID returned when the operation was added
+ * @multi_status: a #GDavMultiStatus, or %NULL
+ * @error: a #GError if the operation failed or was skipped, or %NULL
+ * @user_data: user data passed to gdav_batch_set_func()
+ *
+ * Called as each operation in a #GDavBatch completes.  @multi_status
+ * is the result of a PROPFIND or PROPPATCH, or the failure details of
+ * a DELETE, COPY or MOVE.
+ **/
+typedef void		(*GDavBatchFunc)	(GDavBatch *batch,
+						 guint op_id,
+						 GDavMultiStatus *multi_status,
+						 const GError *error,
+						 gpointer user_data);
+
+/**
+ * GDavBatch:
+ *
+ * Runs a set of WebDAV operations on a #SoupSession with a bounded
+ * number of requests in flight, overall and per host.  Operations
+ * start in the order they were added unless held back by a
+ * dependency added with gdav_batch_add_dependency().
+ **/
+struct _GDavBatch {
+	GObject parent;
+	GDavBatchPrivate *priv;
+};
+
+struct _GDavBatchClass {
+	GObjectClass parent_class;
+};
+
+GType		gdav_batch_get_type		(void) G_GNUC_CONST;
+GDavBatch *	gdav_batch_new			(SoupSession *session);
+SoupSession *	gdav_batch_get_session		(GDavBatch *batch);
+guint		gdav_batch_get_max_concurrent	(GDavBatch *batch);
+void		gdav_batch_set_max_concurrent	(GDavBatch *batch,
+						 guint max_concurrent);
+guint		gdav_batch_get_max_per_host	(GDavBatch *batch);
+void		gdav_batch_set_max_per_host	(GDavBatch *batch,
+						 guint max_per_host);
+GDavBatchPolicy	gdav_batch_get_policy		(GDavBatch *batch);
+void		gdav_batch_set_policy		(GDavBatch *batch,
+						 GDavBatchPolicy policy);
+void		gdav_batch_set_func		(GDavBatch *batch,
+						 GDavBatchFunc func,
+						 gpointer user_data,
+						 GDestroyNotify notify);
+guint		gdav_batch_add_propfind		(GDavBatch *batch,
+						 SoupURI *uri,
+						 GDavPropFindType type,
+						 GDavPropertySet *prop,
+						 GDavDepth depth);
+guint		gdav_batch_add_proppatch	(GDavBatch *batch,
+						 SoupURI *uri,
+						 GDavPropertyUpdate *update);
+guint		gdav_batch_add_mkcol		(GDavBatch *batch,
+						 SoupURI *uri);
+guint		gdav_batch_add_put		(GDavBatch *batch,
+						 SoupURI *uri,
+						 GFile *file,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags);
+guint		gdav_batch_add_delete		(GDavBatch *batch,
+						 SoupURI *uri);
+guint		gdav_batch_add_copy		(GDavBatch *batch,
+						 SoupURI *uri,
+						 const gchar *destination,
+						 GDavCopyFlags flags);
+guint		gdav_batch_add_move		(GDavBatch *batch,
+						 SoupURI *uri,
+						 const gchar *destination,
+						 GDavMoveFlags flags);
+void		gdav_batch_add_dependency	(GDavBatch *batch,
+						 guint op_id,
+						 guint prerequisite_id);
+gboolean	gdav_batch_run_sync		(GDavBatch *batch,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_batch_run			(GDavBatch *batch,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_batch_run_finish		(GDavBatch *batch,
+						 GAsyncResult *result,
+						 GError **error);
+
+G_END_DECLS
+
+#endif /* __GDAV_BATCH_H__ */
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_CACHE_PRIVATE_H__
+#define __GDAV_CACHE_PRIVATE_H__
+
+/* This is a private header, not installed. */
+
+#include "gdav-cache.h"
+
+G_BEGIN_DECLS
+
+GDavCache *	gdav_cache_get_for_session	(SoupSession *session);
+void		gdav_cache_add_conditions	(GDavCache *cache,
+						 SoupMessage *message);
+GBytes *	gdav_cache_lookup_body		(GDavCache *cache,
+						 SoupMessage *message);
+void		gdav_cache_store_body		(GDavCache *cache,
+						 SoupMessage *message,
+						 GBytes *body);
+void		gdav_cache_update_response	(GDavCache *cache,
+						 GDavResponse *response);
+void		gdav_cache_store_multi_status	(GDavCache *cache,
+						 SoupURI *uri,
+						 GDavMultiStatus *multi_status,
+						 gsize size);
+
+G_END_DECLS
+
+#endif /* __GDAV_CACHE_PRIVATE_H__ */
@@ -0,0 +1,910 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gdav-cache.h"
+#include "gdav-cache-private.h"
+
+#include "gdav-getetag-property.h"
+#include "gdav-getlastmodified-property.h"
+
+#define GDAV_CACHE_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), GDAV_TYPE_CACHE, GDavCachePrivate))
+
+#define DEFAULT_MAX_SIZE (16 * 1024 * 1024)
+#define DEFAULT_MAX_ENTRY_SIZE (1024 * 1024)
+
+typedef struct _CacheEntry CacheEntry;
+
+struct _CacheEntry {
+	gchar *key;
+
+	/* Validators as last reported by the server, either
+	 * from a GET response or from a multistatus response. */
+	gchar *etag;
+	GDateTime *last_modified;
+
+	/* Set only if the body matches the validators above. */
+	GBytes *body;
+
+	/* Most recent PROPFIND result for this URI, and
+	 * the size of the response it was parsed from. */
+	GDavMultiStatus *multi_status;
+	gsize multi_status_size;
+
+	/* What this entry counts against the max size. */
+	gsize size;
+	GList *lru_link;
+};
+
+struct _GDavCachePrivate {
+	GMutex lock;
+
+	/* Normalized URI string -> CacheEntry */
+	GHashTable *entries;
+
+	/* All entries, most recently used first. */
+	GQueue lru;
+	gsize total_size;
+
+	gsize max_size;
+	gsize max_entry_size;
+};
+
+enum {
+	PROP_0,
+	PROP_MAX_ENTRY_SIZE,
+	PROP_MAX_SIZE
+};
+
+static void	gdav_cache_session_feature_init
+					(SoupSessionFeatureInterface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (
+	GDavCache,
+	gdav_cache,
+	G_TYPE_OBJECT,
+	G_IMPLEMENT_INTERFACE (
+		SOUP_TYPE_SESSION_FEATURE,
+		gdav_cache_session_feature_init))
+
+static void
+cache_entry_free (CacheEntry *entry)
+{
+	g_free (entry->key);
+	g_free (entry->etag);
+
+	if (entry->last_modified != NULL)
+		g_date_time_unref (entry->last_modified);
+
+	if (entry->body != NULL)
+		g_bytes_unref (entry->body);
+
+	g_clear_object (&entry->multi_status);
+
+	g_slice_free (CacheEntry, entry);
+}
+
+static gchar *
+gdav_cache_uri_key (SoupURI *uri)
+{
+	gchar *key;
+	gsize length;
+
+	key = soup_uri_to_string (uri, FALSE);
+	length = strlen (key);
+
+	/* Collections are reported both with
+	 * and without a trailing slash. */
+	while (length > 0 && key[length - 1] == '/')
+		key[--length] = '\0';
+
+	return key;
+}
+
+/* The following functions must be called with the lock held. */
+
+/* Recomputes what the entry counts against the max size.  Call
+ * this after changing anything the entry holds on to. */
+static void
+gdav_cache_update_size (GDavCache *cache,
+                        CacheEntry *entry)
+{
+	gsize size;
+
+	size = sizeof (CacheEntry) + strlen (entry->key) + 1;
+
+	if (entry->etag != NULL)
+		size += strlen (entry->etag) + 1;
+
+	if (entry->body != NULL)
+		size += g_bytes_get_size (entry->body);
+
+	if (entry->multi_status != NULL)
+		size += entry->multi_status_size;
+
+	cache->priv->total_size -= entry->size;
+	cache->priv->total_size += size;
+	entry->size = size;
+}
+
+static void
+gdav_cache_touch_entry (GDavCache *cache,
+                        CacheEntry *entry)
+{
+	g_queue_unlink (&cache->priv->lru, entry->lru_link);
+	g_queue_push_head_link (&cache->priv->lru, entry->lru_link);
+}
+
+static CacheEntry *
+gdav_cache_lookup_entry (GDavCache *cache,
+                         SoupURI *uri,
+                         gboolean create)
+{
+	CacheEntry *entry;
+	gchar *key;
+
+	key = gdav_cache_uri_key (uri);
+
+	entry = g_hash_table_lookup (cache->priv->entries, key);
+
+	if (entry == NULL && create) {
+		entry = g_slice_new0 (CacheEntry);
+		entry->key = key;
+		g_hash_table_insert (cache->priv->entries, key, entry);
+
+		g_queue_push_head (&cache->priv->lru, entry);
+		entry->lru_link = g_queue_peek_head_link (&cache->priv->lru);
+		gdav_cache_update_size (cache, entry);
+	} else {
+		g_free (key);
+	}
+
+	return entry;
+}
+
+/* Frees the entry, so don't touch it afterward. */
+static void
+gdav_cache_remove_entry (GDavCache *cache,
+                         CacheEntry *entry)
+{
+	cache->priv->total_size -= entry->size;
+	g_queue_delete_link (&cache->priv->lru, entry->lru_link);
+
+	g_hash_table_remove (cache->priv->entries, entry->key);
+}
+
+static void
+gdav_cache_drop_body (GDavCache *cache,
+                      CacheEntry *entry)
+{
+	if (entry->body == NULL)
+		return;
+
+	g_bytes_unref (entry->body);
+	entry->body = NULL;
+
+	gdav_cache_update_size (cache, entry);
+}
+
+static void
+gdav_cache_drop_multi_status (GDavCache *cache,
+                              CacheEntry *entry)
+{
+	if (entry->multi_status == NULL)
+		return;
+
+	g_clear_object (&entry->multi_status);
+	entry->multi_status_size = 0;
+
+	gdav_cache_update_size (cache, entry);
+}
+
+/* Validators, bodies and PROPFIND results all count against
+ * the max size, so the least recently used entries go first
+ * no matter what they hold. */
+static void
+gdav_cache_trim (GDavCache *cache)
+{
+	while (cache->priv->total_size > cache->priv->max_size) {
+		CacheEntry *entry;
+
+		entry = g_queue_peek_tail (&cache->priv->lru);
+		if (entry == NULL)
+			break;
+
+		gdav_cache_remove_entry (cache, entry);
+	}
+}
+
+static void
+gdav_cache_set_validators (GDavCache *cache,
+                           CacheEntry *entry,
+                           const gchar *etag,
+                           GDateTime *last_modified)
+{
+	g_free (entry->etag);
+	entry->etag = g_strdup (etag);
+
+	if (entry->last_modified != NULL)
+		g_date_time_unref (entry->last_modified);
+	entry->last_modified = (last_modified != NULL) ?
+		g_date_time_ref (last_modified) : NULL;
+
+	gdav_cache_update_size (cache, entry);
+}
+
+/* Like gdav_cache_set_validators(), but leaves alone validators
+ * that weren't reported and drops the body if either changed. */
+static void
+gdav_cache_merge_validators (GDavCache *cache,
+                             CacheEntry *entry,
+                             const gchar *etag,
+                             GDateTime *last_modified)
+{
+	if (etag != NULL) {
+		if (g_strcmp0 (etag, entry->etag) != 0) {
+			gdav_cache_drop_body (cache, entry);
+			g_free (entry->etag);
+			entry->etag = g_strdup (etag);
+		}
+	}
+
+	if (last_modified != NULL) {
+		if (entry->last_modified == NULL ||
+		    !g_date_time_equal (last_modified, entry->last_modified)) {
+			gdav_cache_drop_body (cache, entry);
+			if (entry->last_modified != NULL)
+				g_date_time_unref (entry->last_modified);
+			entry->last_modified = g_date_time_ref (last_modified);
+		}
+	}
+
+	gdav_cache_update_size (cache, entry);
+}
+
+static void
+gdav_cache_set_property (GObject *object,
+                         guint property_id,
+                         const GValue *value,
+                         GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_MAX_ENTRY_SIZE:
+			gdav_cache_set_max_entry_size (
+				GDAV_CACHE (object),
+				g_value_get_uint64 (value));
+			return;
+
+		case PROP_MAX_SIZE:
+			gdav_cache_set_max_size (
+				GDAV_CACHE (object),
+				g_value_get_uint64 (value));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+gdav_cache_get_property (GObject *object,
+                         guint property_id,
+                         GValue *value,
+                         GParamSpec *pspec)
+{
+	switch (property_id) {
+		case PROP_MAX_ENTRY_SIZE:
+			g_value_set_uint64 (
+				value,
+				gdav_cache_get_max_entry_size (
+				GDAV_CACHE (object)));
+			return;
+
+		case PROP_MAX_SIZE:
+			g_value_set_uint64 (
+				value,
+				gdav_cache_get_max_size (
+				GDAV_CACHE (object)));
+			return;
+	}
+
+	G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+}
+
+static void
+gdav_cache_finalize (GObject *object)
+{
+	GDavCachePrivate *priv;
+
+	priv = GDAV_CACHE_GET_PRIVATE (object);
+
+	g_queue_clear (&priv->lru);
+	g_hash_table_destroy (priv->entries);
+	g_mutex_clear (&priv->lock);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (gdav_cache_parent_class)->finalize (object);
+}
+
+static void
+gdav_cache_class_init (GDavCacheClass *class)
+{
+	GObjectClass *object_class;
+
+	g_type_class_add_private (class, sizeof (GDavCachePrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->set_property = gdav_cache_set_property;
+	object_class->get_property = gdav_cache_get_property;
+	object_class->finalize = gdav_cache_finalize;
+
+	g_object_class_install_property (
+		object_class,
+		PROP_MAX_ENTRY_SIZE,
+		g_param_spec_uint64 (
+			"max-entry-size",
+			"Max Entry Size",
+			"Largest GET body to cache, in bytes",
+			0, G_MAXSIZE, DEFAULT_MAX_ENTRY_SIZE,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+
+	g_object_class_install_property (
+		object_class,
+		PROP_MAX_SIZE,
+		g_param_spec_uint64 (
+			"max-size",
+			"Max Size",
+			"Total size of cached data, in bytes",
+			0, G_MAXSIZE, DEFAULT_MAX_SIZE,
+			G_PARAM_READWRITE |
+			G_PARAM_CONSTRUCT |
+			G_PARAM_STATIC_STRINGS));
+}
+
+static void
+gdav_cache_session_feature_init (SoupSessionFeatureInterface *iface)
+{
+	/* Nothing to override.  Being a session feature just lets
+	 * the cache be attached with soup_session_add_feature() and
+	 * found again by the functions in gdav-methods.c. */
+}
+
+static void
+gdav_cache_init (GDavCache *cache)
+{
+	cache->priv = GDAV_CACHE_GET_PRIVATE (cache);
+
+	g_mutex_init (&cache->priv->lock);
+
+	cache->priv->entries = g_hash_table_new_full (
+		(GHashFunc) g_str_hash,
+		(GEqualFunc) g_str_equal,
+		(GDestroyNotify) NULL,
+		(GDestroyNotify) cache_entry_free);
+
+	g_queue_init (&cache->priv->lru);
+}
+
+/**
+ * gdav_cache_new:
+ *
+ * Creates a new, empty #GDavCache.  Add it to a #SoupSession with
+ * soup_session_add_feature() to use it.
+ *
+ * Returns: a new #GDavCache
+ **/
+GDavCache *
+gdav_cache_new (void)
+{
+	return g_object_new (GDAV_TYPE_CACHE, NULL);
+}
+
+/**
+ * gdav_cache_get_max_size:
+ * @cache: a #GDavCache
+ *
+ * Returns the total size of data @cache will hold, in bytes.
+ *
+ * Returns: the maximum total size
+ **/
+gsize
+gdav_cache_get_max_size (GDavCache *cache)
+{
+	g_return_val_if_fail (GDAV_IS_CACHE (cache), 0);
+
+	return cache->priv->max_size;
+}
+
+/**
+ * gdav_cache_set_max_size:
+ * @cache: a #GDavCache
+ * @max_size: the maximum total size, in bytes
+ *
+ * Sets the total size of data @cache will hold.  This covers GET
+ * bodies, PROPFIND results and the validators kept for each resource.
+ * The least recently used resources are forgotten to stay within the
+ * limit.
+ **/
+void
+gdav_cache_set_max_size (GDavCache *cache,
+                         gsize max_size)
+{
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+
+	g_mutex_lock (&cache->priv->lock);
+
+	if (cache->priv->max_size == max_size) {
+		g_mutex_unlock (&cache->priv->lock);
+		return;
+	}
+
+	cache->priv->max_size = max_size;
+	gdav_cache_trim (cache);
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	g_object_notify (G_OBJECT (cache), "max-size");
+}
+
+/**
+ * gdav_cache_get_max_entry_size:
+ * @cache: a #GDavCache
+ *
+ * Returns the size of the largest GET body @cache will hold, in bytes.
+ *
+ * Returns: the maximum body size
+ **/
+gsize
+gdav_cache_get_max_entry_size (GDavCache *cache)
+{
+	g_return_val_if_fail (GDAV_IS_CACHE (cache), 0);
+
+	return cache->priv->max_entry_size;
+}
+
+/**
+ * gdav_cache_set_max_entry_size:
+ * @cache: a #GDavCache
+ * @max_entry_size: the maximum body size, in bytes
+ *
+ * Sets the size of the largest GET body @cache will hold.  Larger
+ * bodies are streamed through without being cached.
+ **/
+void
+gdav_cache_set_max_entry_size (GDavCache *cache,
+                               gsize max_entry_size)
+{
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+
+	if (cache->priv->max_entry_size == max_entry_size)
+		return;
+
+	cache->priv->max_entry_size = max_entry_size;
+
+	g_object_notify (G_OBJECT (cache), "max-entry-size");
+}
+
+/**
+ * gdav_cache_dup_etag:
+ * @cache: a #GDavCache
+ * @uri: a #SoupURI
+ *
+ * Returns the entity tag last reported for @uri, either by a GET
+ * response or by a getetag property in a multistatus response.
+ *
+ * Free the returned string with g_free() when finished with it.
+ *
+ * Returns: a newly-allocated entity tag, or %NULL
+ **/
+gchar *
+gdav_cache_dup_etag (GDavCache *cache,
+                     SoupURI *uri)
+{
+	CacheEntry *entry;
+	gchar *etag = NULL;
+
+	g_return_val_if_fail (GDAV_IS_CACHE (cache), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (cache, uri, FALSE);
+	if (entry != NULL)
+		etag = g_strdup (entry->etag);
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	return etag;
+}
+
+/**
+ * gdav_cache_ref_last_modified:
+ * @cache: a #GDavCache
+ * @uri: a #SoupURI
+ *
+ * Returns the modification time last reported for @uri, either by a
+ * GET response or by a getlastmodified property in a multistatus
+ * response.
+ *
+ * Unreference the returned #GDateTime with g_date_time_unref() when
+ * finished with it.
+ *
+ * Returns: a referenced #GDateTime, or %NULL
+ **/
+GDateTime *
+gdav_cache_ref_last_modified (GDavCache *cache,
+                              SoupURI *uri)
+{
+	CacheEntry *entry;
+	GDateTime *last_modified = NULL;
+
+	g_return_val_if_fail (GDAV_IS_CACHE (cache), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (cache, uri, FALSE);
+	if (entry != NULL && entry->last_modified != NULL)
+		last_modified = g_date_time_ref (entry->last_modified);
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	return last_modified;
+}
+
+/**
+ * gdav_cache_ref_multi_status:
+ * @cache: a #GDavCache
+ * @uri: a #SoupURI
+ *
+ * Returns the result of the most recent PROPFIND request for @uri on
+ * a session using @cache, regardless of what properties it asked for.
+ * It may be out of date; it's meant for showing something right away
+ * while a fresh request is in progress.
+ *
+ * Unreference the returned #GDavMultiStatus with g_object_unref() when
+ * finished with it.
+ *
+ * Returns: a referenced #GDavMultiStatus, or %NULL
+ **/
+GDavMultiStatus *
+gdav_cache_ref_multi_status (GDavCache *cache,
+                             SoupURI *uri)
+{
+	CacheEntry *entry;
+	GDavMultiStatus *multi_status = NULL;
+
+	g_return_val_if_fail (GDAV_IS_CACHE (cache), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (cache, uri, FALSE);
+	if (entry != NULL && entry->multi_status != NULL)
+		multi_status = g_object_ref (entry->multi_status);
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	return multi_status;
+}
+
+/**
+ * gdav_cache_invalidate:
+ * @cache: a #GDavCache
+ * @uri: a #SoupURI
+ *
+ * Forgets everything cached for @uri and for any resources below it,
+ * as well as the cached PROPFIND result of its parent collection.
+ * This happens automatically for requests libgdav sends that modify
+ * a resource.
+ **/
+void
+gdav_cache_invalidate (GDavCache *cache,
+                       SoupURI *uri)
+{
+	GHashTableIter iter;
+	CacheEntry *entry;
+	gpointer value;
+	gchar *key;
+	gchar *parent_key;
+	gchar *cp;
+	gsize length;
+
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+	g_return_if_fail (uri != NULL);
+
+	key = gdav_cache_uri_key (uri);
+	length = strlen (key);
+
+	parent_key = g_strdup (key);
+	cp = strrchr (parent_key, '/');
+	if (cp != NULL)
+		*cp = '\0';
+
+	g_mutex_lock (&cache->priv->lock);
+
+	g_hash_table_iter_init (&iter, cache->priv->entries);
+
+	while (g_hash_table_iter_next (&iter, NULL, &value)) {
+		entry = value;
+
+		if (strncmp (entry->key, key, length) != 0)
+			continue;
+
+		if (entry->key[length] != '\0' && entry->key[length] != '/')
+			continue;
+
+		cache->priv->total_size -= entry->size;
+		g_queue_delete_link (&cache->priv->lru, entry->lru_link);
+		g_hash_table_iter_remove (&iter);
+	}
+
+	entry = g_hash_table_lookup (cache->priv->entries, parent_key);
+	if (entry != NULL)
+		gdav_cache_drop_multi_status (cache, entry);
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	g_free (key);
+	g_free (parent_key);
+}
+
+/**
+ * gdav_cache_clear:
+ * @cache: a #GDavCache
+ *
+ * Forgets everything in @cache.
+ **/
+void
+gdav_cache_clear (GDavCache *cache)
+{
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+
+	g_mutex_lock (&cache->priv->lock);
+
+	g_queue_clear (&cache->priv->lru);
+	cache->priv->total_size = 0;
+	g_hash_table_remove_all (cache->priv->entries);
+
+	g_mutex_unlock (&cache->priv->lock);
+}
+
+/* Returns the cache attached to session, if any.  No reference is
+ * added, the session holds one for as long as it's attached. */
+GDavCache *
+gdav_cache_get_for_session (SoupSession *session)
+{
+	SoupSessionFeature *feature;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+
+	feature = soup_session_get_feature (session, GDAV_TYPE_CACHE);
+
+	return (feature != NULL) ? GDAV_CACHE (feature) : NULL;
+}
+
+/* Adds If-None-Match and If-Modified-Since headers to a GET
+ * request if there's a cached body for it to revalidate. */
+void
+gdav_cache_add_conditions (GDavCache *cache,
+                           SoupMessage *message)
+{
+	CacheEntry *entry;
+	SoupMessageHeaders *headers;
+
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+	g_return_if_fail (SOUP_IS_MESSAGE (message));
+
+	headers = message->request_headers;
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (
+		cache, soup_message_get_uri (message), FALSE);
+
+	if (entry != NULL && entry->body != NULL) {
+		if (entry->etag != NULL)
+			soup_message_headers_replace (
+				headers, "If-None-Match", entry->etag);
+
+		if (entry->last_modified != NULL) {
+			SoupDate *date;
+			gchar *date_string;
+
+			date = soup_date_new_from_time_t (
+				g_date_time_to_unix (entry->last_modified));
+			date_string = soup_date_to_string (
+				date, SOUP_DATE_HTTP);
+			soup_message_headers_replace (
+				headers, "If-Modified-Since", date_string);
+			g_free (date_string);
+			soup_date_free (date);
+		}
+	}
+
+	g_mutex_unlock (&cache->priv->lock);
+}
+
+/* Returns the cached body for a GET request answered
+ * with 304 Not Modified, or NULL if it's been dropped. */
+GBytes *
+gdav_cache_lookup_body (GDavCache *cache,
+                        SoupMessage *message)
+{
+	CacheEntry *entry;
+	GBytes *body = NULL;
+
+	g_return_val_if_fail (GDAV_IS_CACHE (cache), NULL);
+	g_return_val_if_fail (SOUP_IS_MESSAGE (message), NULL);
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (
+		cache, soup_message_get_uri (message), FALSE);
+
+	if (entry != NULL && entry->body != NULL) {
+		body = g_bytes_ref (entry->body);
+		gdav_cache_touch_entry (cache, entry);
+	}
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	return body;
+}
+
+/* Stores the body of a successful GET response, along with
+ * the response's validators.  Without a validator the body
+ * could never be revalidated, so it's not kept. */
+void
+gdav_cache_store_body (GDavCache *cache,
+                       SoupMessage *message,
+                       GBytes *body)
+{
+	SoupMessageHeaders *headers;
+	CacheEntry *entry;
+	const gchar *etag;
+	const gchar *header;
+	const gchar *cache_control;
+	GDateTime *last_modified = NULL;
+
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+	g_return_if_fail (SOUP_IS_MESSAGE (message));
+	g_return_if_fail (body != NULL);
+
+	headers = message->response_headers;
+
+	etag = soup_message_headers_get_one (headers, "ETag");
+
+	header = soup_message_headers_get_one (headers, "Last-Modified");
+	if (header != NULL) {
+		SoupDate *date;
+
+		date = soup_date_new_from_string (header);
+		if (date != NULL) {
+			last_modified = g_date_time_new_from_unix_utc (
+				soup_date_to_time_t (date));
+			soup_date_free (date);
+		}
+	}
+
+	cache_control = soup_message_headers_get_list (
+		headers, "Cache-Control");
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (
+		cache, soup_message_get_uri (message), TRUE);
+
+	gdav_cache_drop_body (cache, entry);
+	gdav_cache_set_validators (cache, entry, etag, last_modified);
+
+	if ((etag != NULL || last_modified != NULL) &&
+	    g_bytes_get_size (body) <= cache->priv->max_entry_size &&
+	    (cache_control == NULL ||
+	     !soup_header_contains (cache_control, "no-store"))) {
+		entry->body = g_bytes_ref (body);
+		gdav_cache_update_size (cache, entry);
+	}
+
+	gdav_cache_touch_entry (cache, entry);
+	gdav_cache_trim (cache);
+
+	g_mutex_unlock (&cache->priv->lock);
+
+	if (last_modified != NULL)
+		g_date_time_unref (last_modified);
+}
+
+/* Records the validators in a multistatus response, which drops
+ * any cached body that no longer matches the resource. */
+void
+gdav_cache_update_response (GDavCache *cache,
+                            GDavResponse *response)
+{
+	CacheEntry *entry;
+	SoupURI *uri;
+	const GValue *value;
+	const gchar *etag = NULL;
+	GDateTime *last_modified = NULL;
+
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+	g_return_if_fail (GDAV_IS_RESPONSE (response));
+
+	uri = gdav_response_get_href (response, 0);
+	if (uri == NULL)
+		return;
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETETAG_PROPERTY, NULL);
+	if (value != NULL)
+		etag = g_value_get_string (value);
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETLASTMODIFIED_PROPERTY, NULL);
+	if (value != NULL)
+		last_modified = g_value_get_boxed (value);
+
+	/* Nothing to learn from this response. */
+	if (etag == NULL && last_modified == NULL)
+		return;
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (cache, uri, TRUE);
+	gdav_cache_merge_validators (cache, entry, etag, last_modified);
+	gdav_cache_trim (cache);
+
+	g_mutex_unlock (&cache->priv->lock);
+}
+
+/* Keeps the result of a PROPFIND request for
+ * gdav_cache_ref_multi_status().  The size of the
+ * response body stands in for what the result costs. */
+void
+gdav_cache_store_multi_status (GDavCache *cache,
+                               SoupURI *uri,
+                               GDavMultiStatus *multi_status,
+                               gsize size)
+{
+	CacheEntry *entry;
+
+	g_return_if_fail (GDAV_IS_CACHE (cache));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (GDAV_IS_MULTI_STATUS (multi_status));
+
+	g_mutex_lock (&cache->priv->lock);
+
+	entry = gdav_cache_lookup_entry (cache, uri, TRUE);
+
+	g_clear_object (&entry->multi_status);
+	entry->multi_status = g_object_ref (multi_status);
+	entry->multi_status_size = size;
+	gdav_cache_update_size (cache, entry);
+
+	gdav_cache_touch_entry (cache, entry);
+	gdav_cache_trim (cache);
+
+	g_mutex_unlock (&cache->priv->lock);
+}
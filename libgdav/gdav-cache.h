@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_CACHE_H__
+#define __GDAV_CACHE_H__
+
+#include <libgdav/gdav-multi-status.h>
+
+/* Standard GObject macros */
+#define GDAV_TYPE_CACHE \
+	(gdav_cache_get_type ())
+#define GDAV_CACHE(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST \
+	((obj), GDAV_TYPE_CACHE, GDavCache))
+#define GDAV_CACHE_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_CAST \
+	((cls), GDAV_TYPE_CACHE, GDavCacheClass))
+#define GDAV_IS_CACHE(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE \
+	((obj), GDAV_TYPE_CACHE))
+#define GDAV_IS_CACHE_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_TYPE \
+	((cls), GDAV_TYPE_CACHE))
+#define GDAV_CACHE_GET_CLASS(obj) \
+	(G_TYPE_INSTANCE_GET_CLASS \
+	((obj), GDAV_TYPE_CACHE, GDavCacheClass))
+
+G_BEGIN_DECLS
+
+typedef struct _GDavCache GDavCache;
+typedef struct _GDavCacheClass GDavCacheClass;
+typedef struct _GDavCachePrivate GDavCachePrivate;
+
+/**
+ * GDavCache:
+ *
+ * An in-memory cache of resource validators, GET bodies and PROPFIND
+ * results.  Add it to a #SoupSession with soup_session_add_feature()
+ * to opt in; libgdav then revalidates cached GET bodies with conditional
+ * requests instead of downloading them again.  Everything it holds counts
+ * against #GDavCache:max-size.
+ **/
+struct _GDavCache {
+	GObject parent;
+	GDavCachePrivate *priv;
+};
+
+struct _GDavCacheClass {
+	GObjectClass parent_class;
+};
+
+GType		gdav_cache_get_type		(void) G_GNUC_CONST;
+GDavCache *	gdav_cache_new			(void);
+gsize		gdav_cache_get_max_size		(GDavCache *cache);
+void		gdav_cache_set_max_size		(GDavCache *cache,
+						 gsize max_size);
+gsize		gdav_cache_get_max_entry_size	(GDavCache *cache);
+void		gdav_cache_set_max_entry_size	(GDavCache *cache,
+						 gsize max_entry_size);
+gchar *		gdav_cache_dup_etag		(GDavCache *cache,
+						 SoupURI *uri);
+GDateTime *	gdav_cache_ref_last_modified	(GDavCache *cache,
+						 SoupURI *uri);
+GDavMultiStatus *
+		gdav_cache_ref_multi_status	(GDavCache *cache,
+						 SoupURI *uri);
+void		gdav_cache_invalidate		(GDavCache *cache,
+						 SoupURI *uri);
+void		gdav_cache_clear		(GDavCache *cache);
+
+G_END_DECLS
+
+#endif /* __GDAV_CACHE_H__ */
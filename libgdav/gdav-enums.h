@@ -39,6 +39,17 @@ typedef enum { /*< flags >*/
 	GDAV_ALLOW_UNLOCK = 1 << 15
 } GDavAllow;
 
+typedef enum {
+	GDAV_BATCH_POLICY_FAIL_FAST,
+	GDAV_BATCH_POLICY_CONTINUE
+} GDavBatchPolicy;
+
+typedef enum {
+	GDAV_CHANGE_ADDED,
+	GDAV_CHANGE_REMOVED,
+	GDAV_CHANGE_MODIFIED
+} GDavChange;
+
 typedef enum { /*< flags >*/
 	GDAV_COPY_FLAGS_NONE = 0,
 	GDAV_COPY_FLAGS_NO_OVERWRITE = 1 << 0,
@@ -101,6 +112,11 @@ typedef enum {
 	GDAV_PROPFIND_PROPNAME
 } GDavPropFindType;
 
+typedef enum { /*< flags >*/
+	GDAV_PUT_FLAGS_NONE = 0,
+	GDAV_PUT_FLAGS_NO_OVERWRITE = 1 << 0
+} GDavPutFlags;
+
 typedef enum { /*< flags >*/
 	GDAV_RESOURCE_TYPE_COLLECTION = 1 << 0
 } GDavResourceType;
@@ -0,0 +1,369 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#include "config.h"
+
+#include "gdav-listing.h"
+
+#include "gdav-getcontentlength-property.h"
+#include "gdav-getetag-property.h"
+#include "gdav-getlastmodified-property.h"
+#include "gdav-resourcetype-property.h"
+
+#define GDAV_LISTING_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), GDAV_TYPE_LISTING, GDavListingPrivate))
+
+/* Size of each block in the string chunk. */
+#define STRINGS_BLOCK_SIZE 65536
+
+struct _GDavListingPrivate {
+	/* Owns every string in the columns below. */
+	GStringChunk *strings;
+
+	GArray *hrefs;
+	GArray *statuses;
+	GArray *etags;
+	GArray *content_lengths;
+	GArray *last_modified;
+	GArray *resource_types;
+};
+
+G_DEFINE_TYPE (GDavListing, gdav_listing, G_TYPE_OBJECT)
+
+static void
+gdav_listing_finalize (GObject *object)
+{
+	GDavListingPrivate *priv;
+
+	priv = GDAV_LISTING_GET_PRIVATE (object);
+
+	g_string_chunk_free (priv->strings);
+
+	g_array_free (priv->hrefs, TRUE);
+	g_array_free (priv->statuses, TRUE);
+	g_array_free (priv->etags, TRUE);
+	g_array_free (priv->content_lengths, TRUE);
+	g_array_free (priv->last_modified, TRUE);
+	g_array_free (priv->resource_types, TRUE);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (gdav_listing_parent_class)->finalize (object);
+}
+
+static void
+gdav_listing_class_init (GDavListingClass *class)
+{
+	GObjectClass *object_class;
+
+	g_type_class_add_private (class, sizeof (GDavListingPrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = gdav_listing_finalize;
+}
+
+static void
+gdav_listing_init (GDavListing *listing)
+{
+	listing->priv = GDAV_LISTING_GET_PRIVATE (listing);
+
+	listing->priv->strings = g_string_chunk_new (STRINGS_BLOCK_SIZE);
+
+	/* The string columns are zero-terminated so the
+	 * peek functions can hand out NULL-terminated arrays. */
+	listing->priv->hrefs = g_array_new (
+		TRUE, FALSE, sizeof (const gchar *));
+	listing->priv->statuses = g_array_new (
+		FALSE, FALSE, sizeof (guint));
+	listing->priv->etags = g_array_new (
+		TRUE, FALSE, sizeof (const gchar *));
+	listing->priv->content_lengths = g_array_new (
+		FALSE, FALSE, sizeof (guint64));
+	listing->priv->last_modified = g_array_new (
+		FALSE, FALSE, sizeof (gint64));
+	listing->priv->resource_types = g_array_new (
+		FALSE, FALSE, sizeof (GDavResourceType));
+}
+
+GDavListing *
+gdav_listing_new (void)
+{
+	return g_object_new (GDAV_TYPE_LISTING, NULL);
+}
+
+GDavListing *
+gdav_listing_new_from_multi_status (GDavMultiStatus *multi_status)
+{
+	GDavListing *listing;
+	guint ii, n_responses;
+
+	g_return_val_if_fail (GDAV_IS_MULTI_STATUS (multi_status), NULL);
+
+	listing = gdav_listing_new ();
+
+	n_responses = gdav_multi_status_get_n_responses (multi_status);
+
+	for (ii = 0; ii < n_responses; ii++) {
+		GDavResponse *response;
+
+		response = gdav_multi_status_get_response (multi_status, ii);
+		gdav_listing_append_response (listing, response);
+	}
+
+	return listing;
+}
+
+/**
+ * gdav_listing_new_property_set:
+ *
+ * Returns a new #GDavPropertySet naming the properties that
+ * make up a #GDavListing, for use in a PROPFIND request.
+ *
+ * Returns: a new #GDavPropertySet
+ **/
+GDavPropertySet *
+gdav_listing_new_property_set (void)
+{
+	GDavPropertySet *prop;
+
+	prop = gdav_property_set_new ();
+	gdav_property_set_add_type (prop, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY);
+	gdav_property_set_add_type (prop, GDAV_TYPE_GETETAG_PROPERTY);
+	gdav_property_set_add_type (prop, GDAV_TYPE_GETLASTMODIFIED_PROPERTY);
+	gdav_property_set_add_type (prop, GDAV_TYPE_RESOURCETYPE_PROPERTY);
+
+	return prop;
+}
+
+void
+gdav_listing_append_response (GDavListing *listing,
+                              GDavResponse *response)
+{
+	GDavListingPrivate *priv;
+	SoupURI *uri;
+	const GValue *value;
+	const gchar *href = NULL;
+	const gchar *etag = NULL;
+	guint64 content_length = 0;
+	gint64 last_modified = 0;
+	GDavResourceType resource_type = 0;
+	guint status, prop_status;
+
+	g_return_if_fail (GDAV_IS_LISTING (listing));
+	g_return_if_fail (GDAV_IS_RESPONSE (response));
+
+	priv = listing->priv;
+
+	uri = gdav_response_get_href (response, 0);
+	if (uri != NULL)
+		href = g_string_chunk_insert (
+			priv->strings, soup_uri_get_path (uri));
+
+	/* A response either has a status of its own or a status per
+	 * property.  Every resource has a DAV:resourcetype, so in the
+	 * second case that property's status stands in for the row. */
+	status = gdav_response_get_status (response, NULL);
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_RESOURCETYPE_PROPERTY, &prop_status);
+	if (value != NULL)
+		resource_type = g_value_get_flags (value);
+	if (status == SOUP_STATUS_NONE)
+		status = prop_status;
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETETAG_PROPERTY, NULL);
+	if (value != NULL && g_value_get_string (value) != NULL)
+		etag = g_string_chunk_insert (
+			priv->strings, g_value_get_string (value));
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY, NULL);
+	if (value != NULL)
+		content_length = g_value_get_uint64 (value);
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETLASTMODIFIED_PROPERTY, NULL);
+	if (value != NULL && g_value_get_boxed (value) != NULL)
+		last_modified = g_date_time_to_unix (
+			g_value_get_boxed (value));
+
+	g_array_append_val (priv->hrefs, href);
+	g_array_append_val (priv->statuses, status);
+	g_array_append_val (priv->etags, etag);
+	g_array_append_val (priv->content_lengths, content_length);
+	g_array_append_val (priv->last_modified, last_modified);
+	g_array_append_val (priv->resource_types, resource_type);
+}
+
+guint
+gdav_listing_get_length (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), 0);
+
+	return listing->priv->hrefs->len;
+}
+
+/**
+ * gdav_listing_get_href:
+ * @listing: a #GDavListing
+ * @index: a row number
+ *
+ * Returns the path portion of the first DAV:href in the row's
+ * DAV:response, still percent-encoded as in a #SoupURI.
+ *
+ * Returns: the path for row @index, or %NULL
+ **/
+const gchar *
+gdav_listing_get_href (GDavListing *listing,
+                       guint index)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+	g_return_val_if_fail (index < listing->priv->hrefs->len, NULL);
+
+	return g_array_index (listing->priv->hrefs, const gchar *, index);
+}
+
+guint
+gdav_listing_get_status (GDavListing *listing,
+                         guint index)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), 0);
+	g_return_val_if_fail (index < listing->priv->statuses->len, 0);
+
+	return g_array_index (listing->priv->statuses, guint, index);
+}
+
+const gchar *
+gdav_listing_get_etag (GDavListing *listing,
+                       guint index)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+	g_return_val_if_fail (index < listing->priv->etags->len, NULL);
+
+	return g_array_index (listing->priv->etags, const gchar *, index);
+}
+
+guint64
+gdav_listing_get_content_length (GDavListing *listing,
+                                 guint index)
+{
+	GArray *column;
+
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), 0);
+
+	column = listing->priv->content_lengths;
+	g_return_val_if_fail (index < column->len, 0);
+
+	return g_array_index (column, guint64, index);
+}
+
+/**
+ * gdav_listing_get_last_modified:
+ * @listing: a #GDavListing
+ * @index: a row number
+ *
+ * Returns: the DAV:getlastmodified time for row @index as a
+ *          Unix timestamp, or 0 if not known
+ **/
+gint64
+gdav_listing_get_last_modified (GDavListing *listing,
+                                guint index)
+{
+	GArray *column;
+
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), 0);
+
+	column = listing->priv->last_modified;
+	g_return_val_if_fail (index < column->len, 0);
+
+	return g_array_index (column, gint64, index);
+}
+
+GDavResourceType
+gdav_listing_get_resource_type (GDavListing *listing,
+                                guint index)
+{
+	GArray *column;
+
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), 0);
+
+	column = listing->priv->resource_types;
+	g_return_val_if_fail (index < column->len, 0);
+
+	return g_array_index (column, GDavResourceType, index);
+}
+
+/**
+ * gdav_listing_peek_hrefs:
+ * @listing: a #GDavListing
+ *
+ * Returns the href column as an array of gdav_listing_get_length()
+ * elements.  The array is owned by @listing and is only valid until
+ * another row is appended.  The other peek functions work the same.
+ *
+ * Returns: the href column
+ **/
+const gchar * const *
+gdav_listing_peek_hrefs (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	return (const gchar * const *) listing->priv->hrefs->data;
+}
+
+const guint *
+gdav_listing_peek_statuses (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	return (const guint *) listing->priv->statuses->data;
+}
+
+const gchar * const *
+gdav_listing_peek_etags (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	return (const gchar * const *) listing->priv->etags->data;
+}
+
+const guint64 *
+gdav_listing_peek_content_lengths (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	return (const guint64 *) listing->priv->content_lengths->data;
+}
+
+const gint64 *
+gdav_listing_peek_last_modified (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	return (const gint64 *) listing->priv->last_modified->data;
+}
+
+const GDavResourceType *
+gdav_listing_peek_resource_types (GDavListing *listing)
+{
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	return (const GDavResourceType *) listing->priv->resource_types->data;
+}
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_LISTING_H__
+#define __GDAV_LISTING_H__
+
+#include <libgdav/gdav-enums.h>
+#include <libgdav/gdav-enumtypes.h>
+#include <libgdav/gdav-multi-status.h>
+
+/* Standard GObject macros */
+#define GDAV_TYPE_LISTING \
+	(gdav_listing_get_type ())
+#define GDAV_LISTING(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST \
+	((obj), GDAV_TYPE_LISTING, GDavListing))
+#define GDAV_LISTING_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_CAST \
+	((cls), GDAV_TYPE_LISTING, GDavListingClass))
+#define GDAV_IS_LISTING(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE \
+	((obj), GDAV_TYPE_LISTING))
+#define GDAV_IS_LISTING_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_TYPE \
+	((cls), GDAV_TYPE_LISTING))
+#define GDAV_LISTING_GET_CLASS(obj) \
+	(G_TYPE_INSTANCE_GET_CLASS \
+	((obj), GDAV_TYPE_LISTING, GDavListingClass))
+
+G_BEGIN_DECLS
+
+typedef struct _GDavListing GDavListing;
+typedef struct _GDavListingClass GDavListingClass;
+typedef struct _GDavListingPrivate GDavListingPrivate;
+
+/**
+ * GDavListing:
+ *
+ * A flat summary of a multistatus response, suitable for listing
+ * large collections.  Each row corresponds to one DAV:response and
+ * each column is a contiguous array indexed by row number, so scans
+ * over a single column touch as little memory as possible.
+ **/
+struct _GDavListing {
+	GObject parent;
+	GDavListingPrivate *priv;
+};
+
+struct _GDavListingClass {
+	GObjectClass parent_class;
+};
+
+GType		gdav_listing_get_type		(void) G_GNUC_CONST;
+GDavListing *	gdav_listing_new		(void);
+GDavListing *	gdav_listing_new_from_multi_status
+						(GDavMultiStatus *multi_status);
+GDavPropertySet *
+		gdav_listing_new_property_set	(void);
+void		gdav_listing_append_response	(GDavListing *listing,
+						 GDavResponse *response);
+guint		gdav_listing_get_length		(GDavListing *listing);
+const gchar *	gdav_listing_get_href		(GDavListing *listing,
+						 guint index);
+guint		gdav_listing_get_status		(GDavListing *listing,
+						 guint index);
+const gchar *	gdav_listing_get_etag		(GDavListing *listing,
+						 guint index);
+guint64		gdav_listing_get_content_length	(GDavListing *listing,
+						 guint index);
+gint64		gdav_listing_get_last_modified	(GDavListing *listing,
+						 guint index);
+GDavResourceType
+		gdav_listing_get_resource_type	(GDavListing *listing,
+						 guint index);
+const gchar * const *
+		gdav_listing_peek_hrefs		(GDavListing *listing);
+const guint *	gdav_listing_peek_statuses	(GDavListing *listing);
+const gchar * const *
+		gdav_listing_peek_etags		(GDavListing *listing);
+const guint64 *	gdav_listing_peek_content_lengths
+						(GDavListing *listing);
+const gint64 *	gdav_listing_peek_last_modified
+						(GDavListing *listing);
+const GDavResourceType *
+		gdav_listing_peek_resource_types
+						(GDavListing *listing);
+
+G_END_DECLS
+
+#endif /* __GDAV_LISTING_H__ */
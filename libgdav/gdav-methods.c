@@ -19,28 +19,366 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gdav-methods.h"
 
 #include <glib/gi18n-lib.h>
 
+#include "gdav-cache-private.h"
+#include "gdav-getcontentlength-property.h"
+#include "gdav-getetag-property.h"
+#include "gdav-resourcetype-property.h"
 #include "gdav-utils.h"
+#include "gdav-utils-private.h"
+
+#define PARSE_BUFFER_SIZE 16384
+#define COPY_BUFFER_SIZE 65536
+
+/* gdav_get_parallel() won't split a resource into ranges smaller
+ * than this; the per-request overhead would outweigh the gain. */
+#define PARALLEL_MIN_RANGE_SIZE (1024 * 1024)
+
+/* How much gdav_get_resume() writes between checkpoints,
+ * and how much gdav_put_resume() sends per PUT request. */
+#define RESUME_CHECKPOINT_INTERVAL (8 * 1024 * 1024)
+#define RESUME_SEGMENT_SIZE (8 * 1024 * 1024)
+
+#define CHECKPOINT_GROUP "Transfer"
+
+/* Hrefs per calendar-multiget request.  Large enough to cut the
+ * number of round trips, small enough that servers don't balk. */
+#define MULTIGET_CHUNK_SIZE 100
 
 typedef struct _AsyncContext AsyncContext;
+typedef struct _CrawlContext CrawlContext;
+typedef struct _CrawlVisit CrawlVisit;
+typedef struct _GetContext GetContext;
+typedef struct _MultigetContext MultigetContext;
+typedef struct _ParallelContext ParallelContext;
+typedef struct _ParallelRange ParallelRange;
+typedef struct _ResumeContext ResumeContext;
+typedef struct _PutContext PutContext;
+typedef struct _ParseContext ParseContext;
 
 struct _AsyncContext {
 	SoupMessage *message;
+	GDavListing *listing;
+	GDavMultiStatus *multi_status;
 	GDavAllow allow;
 	GDavOptions options;
 };
 
+struct _CrawlContext {
+	SoupSession *session;
+	GDavPropertySet *prop;
+	GDavResponseFunc func;
+	gpointer func_data;
+	guint max_concurrent;
+	guint n_running;
+	guint n_visits;
+	gboolean stopped;
+	gboolean returned;
+	GError *error;
+
+	/* Collections waiting to be listed. */
+	GQueue pending;
+
+	/* Paths of collections already queued.  Hashed with
+	 * gdav_href_hash(), so a trailing slash is ignored. */
+	GHashTable *visited;
+};
+
+struct _CrawlVisit {
+	GTask *task;
+	SoupURI *uri;
+	gchar *key;
+	gboolean is_root;
+};
+
+struct _GetContext {
+	SoupMessage *message;
+	GInputStream *input_stream;
+	GOutputStream *output_stream;
+	gboolean capture_body;
+	gsize n_buffered;
+	gsize n_written;
+	gchar buffer[COPY_BUFFER_SIZE];
+
+	/* For a GDavCache attached to the session.  The body
+	 * is collected here as it's copied, up to the cache's
+	 * maximum entry size, and stored when it's complete. */
+	GDavCache *cache;
+	GByteArray *cache_buffer;
+	gboolean skip_conditions;
+
+	/* For gdav_get_parallel(), which requests a byte range
+	 * and expects exactly range_length bytes back from an
+	 * entity with a matching entity tag.  If the range is
+	 * the whole entity, a 200 response will do as well. */
+	goffset range_start;
+	goffset range_length;
+	goffset n_received;
+	gchar *etag;
+	gboolean whole_entity;
+
+	/* For gdav_get_resume(), to checkpoint progress. */
+	ResumeContext *resume;
+};
+
+struct _ParallelContext {
+	SoupSession *session;
+	SoupURI *uri;
+	GFile *file;
+	guint max_ranges;
+	goffset content_length;
+	gchar *etag;
+	guint n_running;
+	GError *error;
+
+	/* Cancelled on the first failed range to stop the rest. */
+	GCancellable *cancellable;
+	GCancellable *caller_cancellable;
+	gulong cancelled_handler_id;
+};
+
+struct _ParallelRange {
+	GTask *task;
+	GFileIOStream *io_stream;
+	goffset start;
+	goffset length;
+};
+
+struct _ResumeContext {
+	SoupSession *session;
+	SoupURI *uri;
+	GFile *file;
+	GFile *checkpoint;
+	SoupMessage *message;
+	gchar *etag;
+
+	/* Bytes known to be safely transferred. */
+	goffset offset;
+
+	/* For gdav_get_resume().  The response is held in
+	 * get_context while the file is being opened. */
+	GFileIOStream *io_stream;
+	GetContext *get_context;
+	goffset next_checkpoint;
+	gboolean checkpointing;
+
+	/* For gdav_put_resume(). */
+	GInputStream *input_stream;
+	gchar *content_type;
+	goffset size;
+	guint64 modified;
+	gchar *buffer;
+	gsize n_buffered;
+	gboolean ranged;
+	gboolean range_checked;
+};
+
+struct _MultigetContext {
+	SoupSession *session;
+	SoupURI *uri;
+	GDavPropertySet *prop;
+	gchar **hrefs;
+	guint n_hrefs;
+	guint next_href;
+	guint chunk_size;
+	guint max_concurrent;
+	guint n_running;
+	GDavResponseFunc func;
+	gpointer func_data;
+	gboolean stopped;
+	gboolean returned;
+	GError *error;
+};
+
+struct _PutContext {
+	SoupSession *session;
+	SoupMessage *message;
+	GInputStream *input_stream;
+	goffset content_length;
+	goffset n_read;
+	gpointer buffer;
+	gboolean reading;
+	gboolean eof;
+	gboolean finished;
+	gulong cancelled_handler_id;
+	gchar *etag;
+	GError *error;
+
+	/* For gdav_put_file(), until the file is open. */
+	SoupURI *uri;
+	gchar *content_type;
+	gchar *if_match;
+	GDavPutFlags flags;
+};
+
+struct _ParseContext {
+	SoupMessage *message;
+	GInputStream *input_stream;
+	GDavMultiStatusParser *parser;
+	GDavResponseFunc func;
+	gpointer func_data;
+	GDavCache *cache;
+	gboolean capture_body;
+	gsize n_parsed;
+	gchar buffer[PARSE_BUFFER_SIZE];
+};
+
 static void
 async_context_free (AsyncContext *async_context)
 {
 	g_clear_object (&async_context->message);
+	g_clear_object (&async_context->listing);
+	g_clear_object (&async_context->multi_status);
 
 	g_slice_free (AsyncContext, async_context);
 }
 
+static void
+crawl_context_free (CrawlContext *crawl_context)
+{
+	g_clear_object (&crawl_context->session);
+	g_clear_object (&crawl_context->prop);
+	g_clear_error (&crawl_context->error);
+
+	while (!g_queue_is_empty (&crawl_context->pending))
+		soup_uri_free (g_queue_pop_head (&crawl_context->pending));
+	g_hash_table_destroy (crawl_context->visited);
+
+	g_slice_free (CrawlContext, crawl_context);
+}
+
+static void
+crawl_visit_free (CrawlVisit *visit)
+{
+	g_clear_object (&visit->task);
+	soup_uri_free (visit->uri);
+	g_free (visit->key);
+
+	g_slice_free (CrawlVisit, visit);
+}
+
+static void
+get_context_free (GetContext *get_context)
+{
+	g_clear_object (&get_context->message);
+	g_clear_object (&get_context->input_stream);
+	g_clear_object (&get_context->output_stream);
+	g_clear_object (&get_context->cache);
+
+	if (get_context->cache_buffer != NULL)
+		g_byte_array_unref (get_context->cache_buffer);
+
+	g_free (get_context->etag);
+
+	g_slice_free (GetContext, get_context);
+}
+
+static void
+parallel_context_free (ParallelContext *parallel_context)
+{
+	/* XXX g_cancellable_disconnect() deadlocks if we got
+	 *     here from within the "cancelled" signal emission. */
+	if (parallel_context->cancelled_handler_id > 0)
+		g_signal_handler_disconnect (
+			parallel_context->caller_cancellable,
+			parallel_context->cancelled_handler_id);
+
+	g_clear_object (&parallel_context->session);
+	g_clear_object (&parallel_context->file);
+	g_clear_object (&parallel_context->cancellable);
+	g_clear_object (&parallel_context->caller_cancellable);
+	g_clear_error (&parallel_context->error);
+
+	if (parallel_context->uri != NULL)
+		soup_uri_free (parallel_context->uri);
+
+	g_free (parallel_context->etag);
+
+	g_slice_free (ParallelContext, parallel_context);
+}
+
+static void
+parallel_range_free (ParallelRange *range)
+{
+	g_clear_object (&range->task);
+	g_clear_object (&range->io_stream);
+
+	g_slice_free (ParallelRange, range);
+}
+
+static void
+resume_context_free (ResumeContext *resume_context)
+{
+	g_clear_object (&resume_context->session);
+	g_clear_object (&resume_context->file);
+	g_clear_object (&resume_context->checkpoint);
+	g_clear_object (&resume_context->message);
+	g_clear_object (&resume_context->io_stream);
+	g_clear_object (&resume_context->input_stream);
+
+	if (resume_context->get_context != NULL)
+		get_context_free (resume_context->get_context);
+
+	if (resume_context->uri != NULL)
+		soup_uri_free (resume_context->uri);
+
+	g_free (resume_context->etag);
+	g_free (resume_context->content_type);
+	g_free (resume_context->buffer);
+
+	g_slice_free (ResumeContext, resume_context);
+}
+
+static void
+multiget_context_free (MultigetContext *multiget_context)
+{
+	g_clear_object (&multiget_context->session);
+	g_clear_object (&multiget_context->prop);
+	g_clear_error (&multiget_context->error);
+
+	soup_uri_free (multiget_context->uri);
+	g_strfreev (multiget_context->hrefs);
+
+	g_slice_free (MultigetContext, multiget_context);
+}
+
+static void
+put_context_free (PutContext *put_context)
+{
+	g_clear_object (&put_context->session);
+	g_clear_object (&put_context->message);
+	g_clear_object (&put_context->input_stream);
+	g_clear_error (&put_context->error);
+
+	g_free (put_context->buffer);
+	g_free (put_context->etag);
+
+	if (put_context->uri != NULL)
+		soup_uri_free (put_context->uri);
+	g_free (put_context->content_type);
+	g_free (put_context->if_match);
+
+	g_slice_free (PutContext, put_context);
+}
+
+static void
+parse_context_free (ParseContext *parse_context)
+{
+	g_clear_object (&parse_context->message);
+	g_clear_object (&parse_context->input_stream);
+	g_clear_object (&parse_context->cache);
+
+	if (parse_context->parser != NULL)
+		gdav_multi_status_parser_free (parse_context->parser);
+
+	g_slice_free (ParseContext, parse_context);
+}
+
 static void
 gdav_request_splice_cb (GObject *source_object,
                         GAsyncResult *result,
@@ -167,253 +505,502 @@ gdav_request_send_finish (SoupRequestHTTP *request,
 	return g_task_propagate_boolean (G_TASK (result), error);
 }
 
-gboolean
-gdav_options_sync (SoupSession *session,
-                   SoupURI *uri,
-                   GDavAllow *out_allow,
-                   GDavOptions *out_options,
-                   SoupMessage **out_message,
-                   GCancellable *cancellable,
-                   GError **error)
+static void
+gdav_input_stream_drain_cb (GObject *source_object,
+                            GAsyncResult *result,
+                            gpointer user_data)
 {
-	GDavAsyncClosure *closure;
-	GAsyncResult *result;
-	gboolean success;
-
-	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
-	g_return_val_if_fail (uri != NULL, FALSE);
-
-	closure = gdav_async_closure_new ();
-
-	gdav_options (
-		session, uri, cancellable,
-		gdav_async_closure_callback, closure);
-
-	result = gdav_async_closure_wait (closure);
-
-	success = gdav_options_finish (
-		session, result, out_allow,
-		out_options, out_message, error);
-
-	gdav_async_closure_free (closure);
+	/* Errors don't matter here, the caller already moved on. */
+	g_input_stream_close_finish (
+		G_INPUT_STREAM (source_object), result, NULL);
+}
 
-	return success;
+static void
+gdav_input_stream_drain (GInputStream *input_stream)
+{
+	/* Closing a SoupRequest input stream reads whatever is left
+	 * of the response body so the connection can be reused, and
+	 * g_input_stream_close() does that in blocking mode.  Let it
+	 * happen in the background instead.  The close operation
+	 * holds its own reference on the stream. */
+	g_input_stream_close_async (
+		input_stream, G_PRIORITY_DEFAULT, NULL,
+		gdav_input_stream_drain_cb, NULL);
 }
 
 static void
-gdav_options_request_cb (GObject *source_object,
-                         GAsyncResult *result,
-                         gpointer user_data)
+gdav_request_parse_read (GTask *task);
+
+static void
+gdav_request_parse_read_cb (GObject *source_object,
+                            GAsyncResult *result,
+                            gpointer user_data)
 {
-	SoupRequestHTTP *request;
 	GTask *task = G_TASK (user_data);
-	AsyncContext *async_context;
+	ParseContext *parse_context;
+	GDavMultiStatus *multi_status = NULL;
+	gssize n_read;
 	GError *local_error = NULL;
 
-	request = SOUP_REQUEST_HTTP (source_object);
-	async_context = g_task_get_task_data (task);
+	parse_context = g_task_get_task_data (task);
 
-	gdav_request_send_finish (request, result, &local_error);
+	n_read = g_input_stream_read_finish (
+		G_INPUT_STREAM (source_object), result, &local_error);
 
-	if (local_error == NULL) {
-		async_context->allow =
-			gdav_options_from_headers (
-			async_context->message->response_headers);
-		async_context->options =
-			gdav_options_from_headers (
-			async_context->message->response_headers);
-		g_task_return_boolean (task, TRUE);
-	} else {
-		g_task_return_error (task, local_error);
+	if (n_read < 0) {
+		gdav_input_stream_drain (parse_context->input_stream);
+		goto exit;
 	}
 
-	g_object_unref (task);
-}
+	if (n_read > 0 && parse_context->capture_body) {
+		soup_message_body_append (
+			parse_context->message->response_body,
+			SOUP_MEMORY_COPY,
+			parse_context->buffer, n_read);
+	}
 
-void
-gdav_options (SoupSession *session,
-              SoupURI *uri,
-              GCancellable *cancellable,
-              GAsyncReadyCallback callback,
-              gpointer user_data)
-{
-	GTask *task;
-	SoupRequestHTTP *request;
-	AsyncContext *async_context;
-	GError *local_error = NULL;
+	if (n_read > 0) {
+		parse_context->n_parsed += n_read;
 
-	g_return_if_fail (SOUP_IS_SESSION (session));
-	g_return_if_fail (uri != NULL);
+		gdav_multi_status_parser_push (
+			parse_context->parser,
+			parse_context->buffer, n_read,
+			&local_error);
 
-	async_context = g_slice_new0 (AsyncContext);
+		/* Don't read the rest of a malformed
+		 * body synchronously when it's freed. */
+		if (local_error != NULL) {
+			gdav_input_stream_drain (
+				parse_context->input_stream);
+			goto exit;
+		}
 
-	task = g_task_new (session, cancellable, callback, user_data);
-	g_task_set_source_tag (task, gdav_options);
+		/* Keep reading until EOF unless the caller's
+		 * callback asked us to stop the walk early. */
+		if (!gdav_multi_status_parser_is_stopped (
+			parse_context->parser)) {
+			gdav_request_parse_read (task);
+			goto exit;
+		}
 
-	g_task_set_task_data (
-		task, async_context, (GDestroyNotify) async_context_free);
+		gdav_input_stream_drain (parse_context->input_stream);
+	}
 
-	request = gdav_request_options_uri (session, uri, &local_error);
+	if (parse_context->capture_body) {
+		soup_message_body_flatten (
+			parse_context->message->response_body);
+		soup_message_finished (parse_context->message);
+	}
 
-	/* Sanity check */
-	g_return_if_fail (
-		((request != NULL) && (local_error == NULL)) ||
-		((request == NULL) && (local_error != NULL)));
+	multi_status = gdav_multi_status_parser_finish (
+		parse_context->parser, &local_error);
 
-	if (request != NULL) {
-		async_context->message =
-			soup_request_http_get_message (request);
+	/* With a callback, the cache saw each response as it
+	 * went by.  See gdav_request_parse_response_cb(). */
+	if (multi_status != NULL && parse_context->cache != NULL &&
+	    parse_context->func == NULL) {
+		SoupMessage *message = parse_context->message;
+		guint ii, n_responses;
 
-		gdav_request_send (
-			request, cancellable,
-			gdav_options_request_cb,
-			g_object_ref (task));
+		n_responses =
+			gdav_multi_status_get_n_responses (multi_status);
 
-		g_object_unref (request);
-	} else {
-		g_task_return_error (task, local_error);
+		for (ii = 0; ii < n_responses; ii++)
+			gdav_cache_update_response (
+				parse_context->cache,
+				gdav_multi_status_get_response (
+				multi_status, ii));
+
+		if (message->method == SOUP_METHOD_PROPFIND)
+			gdav_cache_store_multi_status (
+				parse_context->cache,
+				soup_message_get_uri (message),
+				multi_status,
+				parse_context->n_parsed);
 	}
 
+	if (multi_status != NULL)
+		g_task_return_pointer (task, multi_status, g_object_unref);
+
+exit:
+	if (local_error != NULL)
+		g_task_return_error (task, local_error);
+
 	g_object_unref (task);
 }
 
-gboolean
-gdav_options_finish (SoupSession *session,
-                     GAsyncResult *result,
-                     GDavAllow *out_allow,
-                     GDavOptions *out_options,
-                     SoupMessage **out_message,
-                     GError **error)
+static void
+gdav_request_parse_read (GTask *task)
 {
-	AsyncContext *async_context;
+	ParseContext *parse_context;
 
-	g_return_val_if_fail (
-		g_task_is_valid (result, session), FALSE);
-	g_return_val_if_fail (
-		g_async_result_is_tagged (result, gdav_options), FALSE);
+	parse_context = g_task_get_task_data (task);
 
-	async_context = g_task_get_task_data (G_TASK (result));
+	g_input_stream_read_async (
+		parse_context->input_stream,
+		parse_context->buffer,
+		sizeof (parse_context->buffer),
+		G_PRIORITY_DEFAULT,
+		g_task_get_cancellable (task),
+		gdav_request_parse_read_cb,
+		g_object_ref (task));
+}
 
-	if (!g_task_had_error (G_TASK (result))) {
-		if (out_allow != NULL)
-			*out_allow = async_context->allow;
-		if (out_options != NULL)
-			*out_options = async_context->options;
-	}
+static gboolean
+gdav_request_parse_response_cb (GDavResponse *response,
+                                gpointer user_data)
+{
+	ParseContext *parse_context = user_data;
 
-	/* SoupMessage is set even in case of error for uses
-	 * like calling soup_message_get_https_status() when
-	 * SSL/TLS negotiation fails, though SoupMessage may
-	 * be NULL if the Request-URI was invalid. */
-	if (out_message != NULL) {
-		*out_message = async_context->message;
-		async_context->message = NULL;
-	}
+	gdav_cache_update_response (parse_context->cache, response);
 
-	return g_task_propagate_boolean (G_TASK (result), error);
+	return parse_context->func (response, parse_context->func_data);
 }
 
-GDavMultiStatus *
-gdav_propfind_sync (SoupSession *session,
-                    SoupURI *uri,
-                    GDavPropFindType type,
-                    GDavPropertySet *prop,
-                    GDavDepth depth,
-                    SoupMessage **out_message,
-                    GCancellable *cancellable,
-                    GError **error)
+static void
+gdav_request_parse_send_cb (GObject *source_object,
+                            GAsyncResult *result,
+                            gpointer user_data)
 {
-	GDavAsyncClosure *closure;
-	GAsyncResult *result;
-	GDavMultiStatus *multi_status;
+	GTask *task = G_TASK (user_data);
+	ParseContext *parse_context;
+	SoupMessage *message;
+	GError *local_error = NULL;
 
-	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
-	g_return_val_if_fail (uri != NULL, NULL);
+	parse_context = g_task_get_task_data (task);
+	message = parse_context->message;
 
-	closure = gdav_async_closure_new ();
+	parse_context->input_stream = soup_request_send_finish (
+		SOUP_REQUEST (source_object), result, &local_error);
 
-	gdav_propfind (
-		session, uri, type, prop, depth, cancellable,
-		gdav_async_closure_callback, closure);
+	/* Sanity check */
+	g_warn_if_fail (
+		((parse_context->input_stream != NULL) &&
+		 (local_error == NULL)) ||
+		((parse_context->input_stream == NULL) &&
+		 (local_error != NULL)));
 
-	result = gdav_async_closure_wait (closure);
+	if (local_error != NULL) {
+		g_task_return_error (task, local_error);
 
-	multi_status = gdav_propfind_finish (
-		session, result, out_message, error);
+	} else if (message->status_code != SOUP_STATUS_MULTI_STATUS) {
+		gdav_input_stream_drain (parse_context->input_stream);
 
-	gdav_async_closure_free (closure);
+		g_task_return_new_error (
+			task, GDAV_PARSABLE_ERROR,
+			GDAV_PARSABLE_ERROR_INTERNAL,
+			_("Expected status %u (%s), but got (%u) (%s)"),
+			SOUP_STATUS_MULTI_STATUS,
+			soup_status_get_phrase (SOUP_STATUS_MULTI_STATUS),
+			message->status_code,
+			message->reason_phrase);
 
-	return multi_status;
+	} else {
+		SoupSession *session;
+		GDavCache *cache;
+
+		/* Keep a copy of the body only if a SoupLogger
+		 * wants to see it.  See gdav_request_splice_cb()
+		 * for why the body would otherwise be missing. */
+		session = soup_request_get_session (
+			SOUP_REQUEST (source_object));
+		parse_context->capture_body =
+			(message->response_body->length == 0) &&
+			(soup_session_get_feature (
+			session, SOUP_TYPE_LOGGER) != NULL);
+
+		cache = gdav_cache_get_for_session (session);
+		if (cache != NULL)
+			parse_context->cache = g_object_ref (cache);
+
+		if (cache != NULL && parse_context->func != NULL)
+			parse_context->parser = gdav_multi_status_parser_new (
+				soup_message_get_uri (message),
+				gdav_request_parse_response_cb,
+				parse_context);
+		else
+			parse_context->parser = gdav_multi_status_parser_new (
+				soup_message_get_uri (message),
+				parse_context->func,
+				parse_context->func_data);
+
+		gdav_request_parse_read (task);
+	}
+
+	g_object_unref (task);
 }
 
 static void
-gdav_propfind_request_cb (GObject *source_object,
-                          GAsyncResult *result,
-                          gpointer user_data)
+gdav_request_parse (SoupRequestHTTP *request,
+                    GDavResponseFunc func,
+                    gpointer func_data,
+                    GCancellable *cancellable,
+                    GAsyncReadyCallback callback,
+                    gpointer user_data)
+{
+	GTask *task;
+	ParseContext *parse_context;
+
+	/* This is an internal wrapper for soup_request_send_async()
+	 * which expects a multistatus response and feeds the input
+	 * stream to a GDavMultiStatusParser while it's downloading,
+	 * so responses can be handled before the body is complete. */
+
+	parse_context = g_slice_new0 (ParseContext);
+	parse_context->message = soup_request_http_get_message (request);
+	parse_context->func = func;
+	parse_context->func_data = func_data;
+
+	task = g_task_new (request, cancellable, callback, user_data);
+
+	g_task_set_task_data (
+		task, parse_context, (GDestroyNotify) parse_context_free);
+
+	soup_request_send_async (
+		SOUP_REQUEST (request),
+		cancellable,
+		gdav_request_parse_send_cb,
+		g_object_ref (task));
+
+	g_object_unref (task);
+}
+
+static GDavMultiStatus *
+gdav_request_parse_finish (SoupRequestHTTP *request,
+                           GAsyncResult *result,
+                           GError **error)
+{
+	g_return_val_if_fail (g_task_is_valid (result, request), NULL);
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static gboolean
+gdav_message_check_status (SoupMessage *message,
+                           GDavMultiStatus **out_multi_status,
+                           GError **error)
+{
+	/* A multistatus response to anything but PROPFIND or
+	 * PROPPATCH means the method failed for some resources,
+	 * RFC 4918 Section 9.6.1.  Keep it for the details. */
+	if (message->status_code == SOUP_STATUS_MULTI_STATUS) {
+		GDavMultiStatus *multi_status;
+
+		multi_status = gdav_parsable_new_from_data (
+			GDAV_TYPE_MULTI_STATUS,
+			soup_message_get_uri (message),
+			message->response_body->data,
+			message->response_body->length,
+			error);
+
+		if (multi_status == NULL)
+			return FALSE;
+
+		*out_multi_status = multi_status;
+
+		g_set_error (
+			error, SOUP_HTTP_ERROR,
+			message->status_code,
+			_("The operation failed for one or more resources"));
+
+		return FALSE;
+	}
+
+	if (!SOUP_STATUS_IS_SUCCESSFUL (message->status_code)) {
+		g_set_error (
+			error, SOUP_HTTP_ERROR,
+			message->status_code,
+			"%s", message->reason_phrase);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+gdav_method_request_cb (GObject *source_object,
+                        GAsyncResult *result,
+                        gpointer user_data)
 {
-	SoupRequestHTTP *request;
 	GTask *task = G_TASK (user_data);
-	SoupURI *base_uri;
-	gpointer parsable;
-	guint status_code;
 	AsyncContext *async_context;
 	GError *local_error = NULL;
 
-	request = SOUP_REQUEST_HTTP (source_object);
 	async_context = g_task_get_task_data (task);
-	status_code = async_context->message->status_code;
 
-	gdav_request_send_finish (request, result, &local_error);
+	gdav_request_send_finish (
+		SOUP_REQUEST_HTTP (source_object), result, &local_error);
 
-	if (local_error != NULL)
-		goto exit;
+	if (local_error == NULL)
+		gdav_message_check_status (
+			async_context->message,
+			&async_context->multi_status,
+			&local_error);
 
-	if (status_code != SOUP_STATUS_MULTI_STATUS) {
-		g_task_return_new_error (
-			task, GDAV_PARSABLE_ERROR,
-			GDAV_PARSABLE_ERROR_INTERNAL,
-			_("Expected status %u (%s), but got (%u) (%s)"),
-			SOUP_STATUS_MULTI_STATUS,
-			soup_status_get_phrase (SOUP_STATUS_MULTI_STATUS),
-			async_context->message->status_code,
-			async_context->message->reason_phrase);
-		goto exit;
-	}
+	if (local_error == NULL)
+		g_task_return_boolean (task, TRUE);
+	else
+		g_task_return_error (task, local_error);
+
+	g_object_unref (task);
+}
 
-	base_uri = soup_message_get_uri (async_context->message);
+/* Shared by the methods whose only result is the response
+ * status.  Takes ownership of request and local_error. */
+static void
+gdav_method_send_request (GTask *task,
+                          SoupRequestHTTP *request,
+                          GError *local_error)
+{
+	AsyncContext *async_context;
 
-	parsable = gdav_parsable_new_from_data (
-		GDAV_TYPE_MULTI_STATUS, base_uri,
-		async_context->message->response_body->data,
-		async_context->message->response_body->length,
-		&local_error);
+	async_context = g_task_get_task_data (task);
 
 	/* Sanity check */
 	g_warn_if_fail (
-		((parsable != NULL) && (local_error == NULL)) ||
-		((parsable == NULL) && (local_error != NULL)));
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request != NULL) {
+		async_context->message =
+			soup_request_http_get_message (request);
+
+		gdav_request_send (
+			request, g_task_get_cancellable (task),
+			gdav_method_request_cb,
+			g_object_ref (task));
 
-	if (parsable != NULL) {
-		g_warn_if_fail (GDAV_IS_MULTI_STATUS (parsable));
-		g_task_return_pointer (task, parsable, g_object_unref);
+		g_object_unref (request);
+	} else {
+		g_task_return_error (task, local_error);
 	}
+}
 
-exit:
-	if (local_error != NULL)
+static GTask *
+gdav_method_task_new (SoupSession *session,
+                      gpointer source_tag,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+	GTask *task;
+	AsyncContext *async_context;
+
+	async_context = g_slice_new0 (AsyncContext);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, source_tag);
+
+	g_task_set_task_data (
+		task, async_context, (GDestroyNotify) async_context_free);
+
+	return task;
+}
+
+static gboolean
+gdav_method_finish (SoupSession *session,
+                    GAsyncResult *result,
+                    gpointer source_tag,
+                    GDavMultiStatus **out_multi_status,
+                    SoupMessage **out_message,
+                    GError **error)
+{
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, source_tag), FALSE);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	if (out_multi_status != NULL) {
+		*out_multi_status = async_context->multi_status;
+		async_context->multi_status = NULL;
+	}
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = async_context->message;
+		async_context->message = NULL;
+	}
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+gboolean
+gdav_options_sync (SoupSession *session,
+                   SoupURI *uri,
+                   GDavAllow *out_allow,
+                   GDavOptions *out_options,
+                   SoupMessage **out_message,
+                   GCancellable *cancellable,
+                   GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_options (
+		session, uri, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_options_finish (
+		session, result, out_allow,
+		out_options, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void
+gdav_options_request_cb (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	SoupRequestHTTP *request;
+	GTask *task = G_TASK (user_data);
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	request = SOUP_REQUEST_HTTP (source_object);
+	async_context = g_task_get_task_data (task);
+
+	gdav_request_send_finish (request, result, &local_error);
+
+	if (local_error == NULL) {
+		async_context->allow =
+			gdav_options_from_headers (
+			async_context->message->response_headers);
+		async_context->options =
+			gdav_options_from_headers (
+			async_context->message->response_headers);
+		g_task_return_boolean (task, TRUE);
+	} else {
 		g_task_return_error (task, local_error);
+	}
 
 	g_object_unref (task);
 }
 
 void
-gdav_propfind (SoupSession *session,
-               SoupURI *uri,
-               GDavPropFindType type,
-               GDavPropertySet *prop,
-               GDavDepth depth,
-               GCancellable *cancellable,
-               GAsyncReadyCallback callback,
-               gpointer user_data)
+gdav_options (SoupSession *session,
+              SoupURI *uri,
+              GCancellable *cancellable,
+              GAsyncReadyCallback callback,
+              gpointer user_data)
 {
 	GTask *task;
 	SoupRequestHTTP *request;
@@ -426,16 +1013,15 @@ gdav_propfind (SoupSession *session,
 	async_context = g_slice_new0 (AsyncContext);
 
 	task = g_task_new (session, cancellable, callback, user_data);
-	g_task_set_source_tag (task, gdav_propfind);
+	g_task_set_source_tag (task, gdav_options);
 
 	g_task_set_task_data (
 		task, async_context, (GDestroyNotify) async_context_free);
 
-	request = gdav_request_propfind_uri (
-		session, uri, type, prop, depth, &local_error);
+	request = gdav_request_options_uri (session, uri, &local_error);
 
 	/* Sanity check */
-	g_warn_if_fail (
+	g_return_if_fail (
 		((request != NULL) && (local_error == NULL)) ||
 		((request == NULL) && (local_error != NULL)));
 
@@ -445,7 +1031,7 @@ gdav_propfind (SoupSession *session,
 
 		gdav_request_send (
 			request, cancellable,
-			gdav_propfind_request_cb,
+			gdav_options_request_cb,
 			g_object_ref (task));
 
 		g_object_unref (request);
@@ -456,21 +1042,30 @@ gdav_propfind (SoupSession *session,
 	g_object_unref (task);
 }
 
-GDavMultiStatus *
-gdav_propfind_finish (SoupSession *session,
-                      GAsyncResult *result,
-                      SoupMessage **out_message,
-                      GError **error)
+gboolean
+gdav_options_finish (SoupSession *session,
+                     GAsyncResult *result,
+                     GDavAllow *out_allow,
+                     GDavOptions *out_options,
+                     SoupMessage **out_message,
+                     GError **error)
 {
 	AsyncContext *async_context;
 
 	g_return_val_if_fail (
-		g_task_is_valid (result, session), NULL);
+		g_task_is_valid (result, session), FALSE);
 	g_return_val_if_fail (
-		g_async_result_is_tagged (result, gdav_propfind), FALSE);
+		g_async_result_is_tagged (result, gdav_options), FALSE);
 
 	async_context = g_task_get_task_data (G_TASK (result));
 
+	if (!g_task_had_error (G_TASK (result))) {
+		if (out_allow != NULL)
+			*out_allow = async_context->allow;
+		if (out_options != NULL)
+			*out_options = async_context->options;
+	}
+
 	/* SoupMessage is set even in case of error for uses
 	 * like calling soup_message_get_https_status() when
 	 * SSL/TLS negotiation fails, though SoupMessage may
@@ -480,6 +1075,4485 @@ gdav_propfind_finish (SoupSession *session,
 		async_context->message = NULL;
 	}
 
-	return g_task_propagate_pointer (G_TASK (result), error);
+	return g_task_propagate_boolean (G_TASK (result), error);
 }
 
+gboolean
+gdav_get_sync (SoupSession *session,
+               SoupURI *uri,
+               GOutputStream *output_stream,
+               SoupMessage **out_message,
+               GCancellable *cancellable,
+               GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (G_IS_OUTPUT_STREAM (output_stream), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_get (
+		session, uri, output_stream, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_get_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void
+gdav_get_read (GTask *task);
+
+static void
+gdav_get_resume_progress (ResumeContext *resume_context,
+                          GOutputStream *output_stream,
+                          gsize n_written);
+
+static void
+gdav_get_write_cb (GObject *source_object,
+                   GAsyncResult *result,
+                   gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GetContext *get_context;
+	gssize n_written;
+	GError *local_error = NULL;
+
+	get_context = g_task_get_task_data (task);
+
+	n_written = g_output_stream_write_finish (
+		G_OUTPUT_STREAM (source_object), result, &local_error);
+
+	if (n_written < 0) {
+		gdav_input_stream_drain (get_context->input_stream);
+		g_task_return_error (task, local_error);
+	} else {
+		get_context->n_written += n_written;
+
+		if (get_context->resume != NULL)
+			gdav_get_resume_progress (
+				get_context->resume,
+				get_context->output_stream,
+				n_written);
+
+		gdav_get_read (task);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_read_cb (GObject *source_object,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GetContext *get_context;
+	gssize n_read;
+	GError *local_error = NULL;
+
+	get_context = g_task_get_task_data (task);
+
+	n_read = g_input_stream_read_finish (
+		G_INPUT_STREAM (source_object), result, &local_error);
+
+	if (n_read > 0)
+		get_context->n_received += n_read;
+
+	if (n_read > 0 && get_context->cache_buffer != NULL) {
+		GDavCache *cache = get_context->cache;
+
+		/* Too big to cache, just stream it. */
+		if (get_context->n_received >
+		    gdav_cache_get_max_entry_size (cache)) {
+			g_byte_array_unref (get_context->cache_buffer);
+			get_context->cache_buffer = NULL;
+		} else {
+			g_byte_array_append (
+				get_context->cache_buffer,
+				(guint8 *) get_context->buffer, n_read);
+		}
+	}
+
+	if (n_read >= 0 && get_context->range_length > 0) {
+		if (get_context->n_received > get_context->range_length)
+			local_error = g_error_new_literal (
+				G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+				_("Server sent more data than requested"));
+		else if (n_read == 0 &&
+			 get_context->n_received < get_context->range_length)
+			local_error = g_error_new_literal (
+				G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+				_("Server sent less data than requested"));
+
+		if (local_error != NULL)
+			n_read = -1;
+	}
+
+	/* Don't leave the rest of the body for get_context_free()
+	 * to read synchronously when it drops the stream. */
+	if (n_read < 0) {
+		gdav_input_stream_drain (get_context->input_stream);
+		g_task_return_error (task, local_error);
+
+	} else if (n_read == 0) {
+		gdav_input_stream_drain (get_context->input_stream);
+
+		if (get_context->capture_body) {
+			soup_message_body_flatten (
+				get_context->message->response_body);
+			soup_message_finished (get_context->message);
+		}
+
+		if (get_context->cache_buffer != NULL) {
+			GBytes *bytes;
+
+			bytes = g_byte_array_free_to_bytes (
+				get_context->cache_buffer);
+			get_context->cache_buffer = NULL;
+
+			gdav_cache_store_body (
+				get_context->cache,
+				get_context->message, bytes);
+
+			g_bytes_unref (bytes);
+		}
+
+		g_task_return_boolean (task, TRUE);
+
+	} else {
+		if (get_context->capture_body)
+			soup_message_body_append (
+				get_context->message->response_body,
+				SOUP_MEMORY_COPY,
+				get_context->buffer, n_read);
+
+		get_context->n_buffered = n_read;
+		get_context->n_written = 0;
+		gdav_get_read (task);
+	}
+
+	g_object_unref (task);
+}
+
+/* Writes out whatever is left in the buffer, then reads more. */
+static void
+gdav_get_read (GTask *task)
+{
+	GetContext *get_context;
+
+	get_context = g_task_get_task_data (task);
+
+	if (get_context->n_written < get_context->n_buffered) {
+		g_output_stream_write_async (
+			get_context->output_stream,
+			get_context->buffer + get_context->n_written,
+			get_context->n_buffered - get_context->n_written,
+			G_PRIORITY_DEFAULT,
+			g_task_get_cancellable (task),
+			gdav_get_write_cb,
+			g_object_ref (task));
+	} else {
+		g_input_stream_read_async (
+			get_context->input_stream,
+			get_context->buffer,
+			sizeof (get_context->buffer),
+			G_PRIORITY_DEFAULT,
+			g_task_get_cancellable (task),
+			gdav_get_read_cb,
+			g_object_ref (task));
+	}
+}
+
+static gboolean
+gdav_get_check_range (GetContext *get_context,
+                      GError **error)
+{
+	SoupMessage *message;
+	const gchar *etag;
+	goffset start = 0;
+	goffset end = 0;
+
+	message = get_context->message;
+
+	/* The entity changed since we looked it up. */
+	if (message->status_code == SOUP_STATUS_PRECONDITION_FAILED) {
+		g_set_error_literal (
+			error, G_IO_ERROR, G_IO_ERROR_WRONG_ETAG,
+			_("Resource changed during download"));
+		return FALSE;
+	}
+
+	/* The server ignored the Range header, which
+	 * only matters if we asked for part of the entity. */
+	if (message->status_code == SOUP_STATUS_OK) {
+		if (!get_context->whole_entity) {
+			g_set_error_literal (
+				error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+				_("Server does not support byte ranges"));
+			return FALSE;
+		}
+
+	} else if (message->status_code != SOUP_STATUS_PARTIAL_CONTENT) {
+		g_set_error_literal (
+			error, SOUP_HTTP_ERROR, message->status_code,
+			message->reason_phrase);
+		return FALSE;
+
+	} else if (!soup_message_headers_get_content_range (
+		message->response_headers, &start, &end, NULL) ||
+	    start != get_context->range_start ||
+	    end != get_context->range_start + get_context->range_length - 1) {
+		g_set_error_literal (
+			error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+			_("Server returned the wrong byte range"));
+		return FALSE;
+	}
+
+	/* If-Match only covers strong entity tags,
+	 * so compare what came back as well. */
+	etag = soup_message_headers_get_one (
+		message->response_headers, "ETag");
+
+	if (etag != NULL && g_strcmp0 (etag, get_context->etag) != 0) {
+		g_set_error_literal (
+			error, G_IO_ERROR, G_IO_ERROR_WRONG_ETAG,
+			_("Resource changed during download"));
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void	gdav_get_send			(GTask *task,
+						 SoupSession *session,
+						 SoupURI *uri);
+
+static void
+gdav_get_send_cb (GObject *source_object,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GetContext *get_context;
+	SoupMessage *message;
+	SoupSession *session;
+	GError *local_error = NULL;
+
+	get_context = g_task_get_task_data (task);
+	message = get_context->message;
+
+	get_context->input_stream = soup_request_send_finish (
+		SOUP_REQUEST (source_object), result, &local_error);
+
+	if (get_context->input_stream == NULL) {
+		g_task_return_error (task, local_error);
+
+	} else if (get_context->range_length > 0 &&
+		   !gdav_get_check_range (get_context, &local_error)) {
+		gdav_input_stream_drain (get_context->input_stream);
+
+		g_task_return_error (task, local_error);
+
+	} else if (message->status_code == SOUP_STATUS_NOT_MODIFIED &&
+		   get_context->cache != NULL) {
+		GBytes *body;
+
+		gdav_input_stream_drain (get_context->input_stream);
+		g_clear_object (&get_context->input_stream);
+
+		body = gdav_cache_lookup_body (get_context->cache, message);
+
+		if (body != NULL) {
+			/* Copy the cached body to the caller's stream. */
+			get_context->input_stream =
+				g_memory_input_stream_new_from_bytes (body);
+			g_bytes_unref (body);
+
+			gdav_get_read (task);
+		} else {
+			SoupURI *uri;
+
+			/* The body was dropped from the cache
+			 * since we asked.  Ask again without the
+			 * conditions. */
+			session = soup_request_get_session (
+				SOUP_REQUEST (source_object));
+			uri = soup_uri_copy (soup_message_get_uri (message));
+
+			get_context->skip_conditions = TRUE;
+			gdav_get_send (task, session, uri);
+
+			soup_uri_free (uri);
+		}
+
+	/* Don't write an error page into the caller's stream. */
+	} else if (!SOUP_STATUS_IS_SUCCESSFUL (message->status_code)) {
+		gdav_input_stream_drain (get_context->input_stream);
+
+		g_task_return_new_error (
+			task, SOUP_HTTP_ERROR,
+			message->status_code,
+			"%s", message->reason_phrase);
+
+	} else {
+		/* The body goes straight to the caller's stream.
+		 * Only keep a copy in the SoupMessage when a
+		 * SoupLogger is attached and wants to see it. */
+		session = soup_request_get_session (
+			SOUP_REQUEST (source_object));
+		get_context->capture_body =
+			(message->response_body->length == 0) &&
+			(soup_session_get_feature (
+			session, SOUP_TYPE_LOGGER) != NULL);
+
+		if (get_context->cache != NULL)
+			get_context->cache_buffer = g_byte_array_new ();
+
+		gdav_get_read (task);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_send (GTask *task,
+               SoupSession *session,
+               SoupURI *uri)
+{
+	SoupRequestHTTP *request;
+	GetContext *get_context;
+	GError *local_error = NULL;
+
+	get_context = g_task_get_task_data (task);
+
+	request = gdav_request_get_uri (session, uri, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request == NULL) {
+		g_task_return_error (task, local_error);
+		return;
+	}
+
+	g_clear_object (&get_context->message);
+	get_context->message = soup_request_http_get_message (request);
+
+	/* Byte ranges are never cached. */
+	if (get_context->range_length == 0) {
+		GDavCache *cache;
+
+		cache = gdav_cache_get_for_session (session);
+
+		if (cache != NULL && get_context->cache == NULL)
+			get_context->cache = g_object_ref (cache);
+
+		if (cache != NULL && !get_context->skip_conditions)
+			gdav_cache_add_conditions (
+				cache, get_context->message);
+	}
+
+	if (get_context->range_length > 0) {
+		SoupMessageHeaders *headers;
+
+		headers = get_context->message->request_headers;
+
+		soup_message_headers_set_range (
+			headers, get_context->range_start,
+			get_context->range_start +
+			get_context->range_length - 1);
+
+		/* Weak entity tags can't be used with If-Match. */
+		if (!g_str_has_prefix (get_context->etag, "W/"))
+			soup_message_headers_append (
+				headers, "If-Match", get_context->etag);
+	}
+
+	soup_request_send_async (
+		SOUP_REQUEST (request),
+		g_task_get_cancellable (task),
+		gdav_get_send_cb,
+		g_object_ref (task));
+
+	g_object_unref (request);
+}
+
+/**
+ * gdav_get:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @output_stream: a #GOutputStream to write the response body to
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Downloads @uri and writes the response body to @output_stream as it
+ * arrives, using a fixed-size buffer regardless of the resource size.
+ * @output_stream is not closed.  Nothing is written if the server
+ * responds with an error status.
+ *
+ * The body is also kept in the #SoupMessage only if a #SoupLogger is
+ * attached to @session, for debugging.
+ **/
+void
+gdav_get (SoupSession *session,
+          SoupURI *uri,
+          GOutputStream *output_stream,
+          GCancellable *cancellable,
+          GAsyncReadyCallback callback,
+          gpointer user_data)
+{
+	GTask *task;
+	GetContext *get_context;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_OUTPUT_STREAM (output_stream));
+
+	get_context = g_slice_new0 (GetContext);
+	get_context->output_stream = g_object_ref (output_stream);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_get);
+
+	g_task_set_task_data (
+		task, get_context, (GDestroyNotify) get_context_free);
+
+	gdav_get_send (task, session, uri);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_get_finish (SoupSession *session,
+                 GAsyncResult *result,
+                 SoupMessage **out_message,
+                 GError **error)
+{
+	GetContext *get_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_get), FALSE);
+
+	get_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = get_context->message;
+		get_context->message = NULL;
+	}
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+gboolean
+gdav_get_parallel_sync (SoupSession *session,
+                        SoupURI *uri,
+                        GFile *file,
+                        guint max_ranges,
+                        GCancellable *cancellable,
+                        GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_get_parallel (
+		session, uri, file, max_ranges, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_get_parallel_finish (session, result, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void
+gdav_get_parallel_range_done (ParallelRange *range,
+                              GError *error)
+{
+	GTask *task = g_object_ref (range->task);
+	ParallelContext *parallel_context;
+
+	parallel_context = g_task_get_task_data (task);
+
+	/* Local file, not worth going async for.  Ignore the
+	 * cancellable so the descriptor is closed regardless. */
+	if (range->io_stream != NULL)
+		g_io_stream_close (
+			G_IO_STREAM (range->io_stream), NULL,
+			(error == NULL) ? &error : NULL);
+
+	parallel_range_free (range);
+
+	/* Keep the first error and stop the other ranges. */
+	if (error != NULL && parallel_context->error == NULL) {
+		parallel_context->error = error;
+		g_cancellable_cancel (parallel_context->cancellable);
+	} else {
+		g_clear_error (&error);
+	}
+
+	parallel_context->n_running--;
+
+	if (parallel_context->n_running == 0) {
+		if (parallel_context->error != NULL) {
+			g_task_return_error (task, parallel_context->error);
+			parallel_context->error = NULL;
+		} else {
+			g_task_return_boolean (task, TRUE);
+		}
+	}
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_parallel_range_cb (GObject *source_object,
+                            GAsyncResult *result,
+                            gpointer user_data)
+{
+	ParallelRange *range = user_data;
+	GError *local_error = NULL;
+
+	g_task_propagate_boolean (G_TASK (result), &local_error);
+
+	gdav_get_parallel_range_done (range, local_error);
+}
+
+static void
+gdav_get_parallel_open_cb (GObject *source_object,
+                           GAsyncResult *result,
+                           gpointer user_data)
+{
+	ParallelRange *range = user_data;
+	ParallelContext *parallel_context;
+	GetContext *get_context;
+	GOutputStream *output_stream;
+	GTask *range_task;
+	GError *local_error = NULL;
+
+	parallel_context = g_task_get_task_data (range->task);
+
+	range->io_stream = g_file_open_readwrite_finish (
+		G_FILE (source_object), result, &local_error);
+
+	if (range->io_stream != NULL)
+		g_seekable_seek (
+			G_SEEKABLE (range->io_stream),
+			range->start, G_SEEK_SET,
+			NULL, &local_error);
+
+	if (local_error != NULL) {
+		gdav_get_parallel_range_done (range, local_error);
+		return;
+	}
+
+	output_stream = g_io_stream_get_output_stream (
+		G_IO_STREAM (range->io_stream));
+
+	get_context = g_slice_new0 (GetContext);
+	get_context->output_stream = g_object_ref (output_stream);
+	get_context->range_start = range->start;
+	get_context->range_length = range->length;
+	get_context->etag = g_strdup (parallel_context->etag);
+	get_context->whole_entity =
+		(range->start == 0) &&
+		(range->length == parallel_context->content_length);
+
+	range_task = g_task_new (
+		parallel_context->session,
+		parallel_context->cancellable,
+		gdav_get_parallel_range_cb, range);
+	g_task_set_source_tag (range_task, gdav_get_parallel);
+
+	g_task_set_task_data (
+		range_task, get_context,
+		(GDestroyNotify) get_context_free);
+
+	gdav_get_send (
+		range_task,
+		parallel_context->session,
+		parallel_context->uri);
+
+	g_object_unref (range_task);
+}
+
+static void
+gdav_get_parallel_replace_cb (GObject *source_object,
+                              GAsyncResult *result,
+                              gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ParallelContext *parallel_context;
+	GFileOutputStream *output_stream;
+	goffset range_size;
+	goffset offset = 0;
+	guint n_ranges, ii;
+	GError *local_error = NULL;
+
+	parallel_context = g_task_get_task_data (task);
+
+	output_stream = g_file_replace_finish (
+		G_FILE (source_object), result, &local_error);
+
+	if (output_stream != NULL) {
+		/* Size the file up front so each range can be
+		 * written in place through its own descriptor. */
+		g_seekable_truncate (
+			G_SEEKABLE (output_stream),
+			parallel_context->content_length,
+			NULL, &local_error);
+
+		g_output_stream_close (
+			G_OUTPUT_STREAM (output_stream), NULL,
+			(local_error == NULL) ? &local_error : NULL);
+
+		g_object_unref (output_stream);
+	}
+
+	if (local_error != NULL) {
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	if (parallel_context->content_length == 0) {
+		g_task_return_boolean (task, TRUE);
+		g_object_unref (task);
+		return;
+	}
+
+	n_ranges = (parallel_context->content_length +
+		PARALLEL_MIN_RANGE_SIZE - 1) / PARALLEL_MIN_RANGE_SIZE;
+	n_ranges = CLAMP (n_ranges, 1, parallel_context->max_ranges);
+	range_size = parallel_context->content_length / n_ranges;
+
+	parallel_context->n_running = n_ranges;
+
+	for (ii = 0; ii < n_ranges; ii++) {
+		ParallelRange *range;
+
+		range = g_slice_new0 (ParallelRange);
+		range->task = g_object_ref (task);
+		range->start = offset;
+
+		/* The last range picks up the remainder. */
+		if (ii == n_ranges - 1)
+			range->length =
+				parallel_context->content_length - offset;
+		else
+			range->length = range_size;
+
+		offset += range->length;
+
+		g_file_open_readwrite_async (
+			parallel_context->file,
+			G_PRIORITY_DEFAULT,
+			parallel_context->cancellable,
+			gdav_get_parallel_open_cb,
+			range);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_parallel_propfind_cb (GObject *source_object,
+                               GAsyncResult *result,
+                               gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ParallelContext *parallel_context;
+	GDavMultiStatus *multi_status;
+	GDavResponse *response = NULL;
+	SoupMessage *message = NULL;
+	const gchar *accept_ranges = NULL;
+	const GValue *length_value = NULL;
+	const GValue *etag_value = NULL;
+	GError *local_error = NULL;
+
+	parallel_context = g_task_get_task_data (task);
+
+	multi_status = gdav_propfind_finish (
+		SOUP_SESSION (source_object), result,
+		&message, &local_error);
+
+	if (multi_status == NULL) {
+		g_task_return_error (task, local_error);
+		g_clear_object (&message);
+		g_object_unref (task);
+		return;
+	}
+
+	response = gdav_multi_status_get_response_by_href (
+		multi_status, parallel_context->uri);
+
+	if (response == NULL)
+		response = gdav_multi_status_get_response (multi_status, 0);
+
+	if (response != NULL) {
+		length_value = gdav_response_peek_property (
+			response, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY, NULL);
+		etag_value = gdav_response_peek_property (
+			response, GDAV_TYPE_GETETAG_PROPERTY, NULL);
+	}
+
+	if (message != NULL)
+		accept_ranges = soup_message_headers_get_one (
+			message->response_headers, "Accept-Ranges");
+
+	/* Still works, just in one piece. */
+	if (accept_ranges != NULL &&
+	    g_ascii_strcasecmp (accept_ranges, "none") == 0)
+		parallel_context->max_ranges = 1;
+
+	if (length_value == NULL) {
+		g_task_return_new_error (
+			task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			"%s", _("Server did not report the resource size"));
+
+	} else if (etag_value == NULL ||
+		   g_value_get_string (etag_value) == NULL) {
+		g_task_return_new_error (
+			task, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			"%s", _("Server did not report an entity tag "
+			"for the resource"));
+
+	} else {
+		parallel_context->content_length =
+			(goffset) g_value_get_uint64 (length_value);
+		parallel_context->etag =
+			g_strdup (g_value_get_string (etag_value));
+
+		g_file_replace_async (
+			parallel_context->file,
+			NULL, FALSE, G_FILE_CREATE_NONE,
+			G_PRIORITY_DEFAULT,
+			parallel_context->cancellable,
+			gdav_get_parallel_replace_cb,
+			g_object_ref (task));
+	}
+
+	g_object_unref (multi_status);
+	g_clear_object (&message);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_parallel_cancelled_cb (GCancellable *cancellable,
+                                GCancellable *parallel_cancellable)
+{
+	g_cancellable_cancel (parallel_cancellable);
+}
+
+/**
+ * gdav_get_parallel:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @file: a #GFile to download to
+ * @max_ranges: the most byte ranges to download at once
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Downloads @uri to @file as up to @max_ranges byte ranges fetched
+ * concurrently, which can make better use of high-latency links than
+ * a single stream.  The resource size and entity tag are looked up
+ * first with a PROPFIND, @file is created at full size, and each range
+ * is written in place as it arrives.  Resources are not split into
+ * ranges smaller than one megabyte.
+ *
+ * Every range is requested with If-Match and its entity tag is checked,
+ * so if the resource changes during the download the operation fails
+ * with %G_IO_ERROR_WRONG_ETAG.  A resource that fits in a single range,
+ * or a server that sends "Accept-Ranges: none", gets one range covering
+ * the whole entity, and a plain 200 response is accepted for it.  If
+ * the server ignores the Range header otherwise, the operation fails
+ * with %G_IO_ERROR_NOT_SUPPORTED, and the caller can fall back to
+ * gdav_get().  On failure @file is left with partial content.
+ *
+ * The number of ranges actually in flight is also bounded by the
+ * #SoupSession:max-conns-per-host property of @session.
+ **/
+void
+gdav_get_parallel (SoupSession *session,
+                   SoupURI *uri,
+                   GFile *file,
+                   guint max_ranges,
+                   GCancellable *cancellable,
+                   GAsyncReadyCallback callback,
+                   gpointer user_data)
+{
+	GTask *task;
+	ParallelContext *parallel_context;
+	GDavPropertySet *prop;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_FILE (file));
+	g_return_if_fail (max_ranges > 0);
+
+	parallel_context = g_slice_new0 (ParallelContext);
+	parallel_context->session = g_object_ref (session);
+	parallel_context->uri = soup_uri_copy (uri);
+	parallel_context->file = g_object_ref (file);
+	parallel_context->max_ranges = max_ranges;
+	parallel_context->cancellable = g_cancellable_new ();
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_get_parallel);
+
+	g_task_set_task_data (
+		task, parallel_context,
+		(GDestroyNotify) parallel_context_free);
+
+	if (cancellable != NULL) {
+		parallel_context->caller_cancellable =
+			g_object_ref (cancellable);
+		parallel_context->cancelled_handler_id =
+			g_cancellable_connect (
+				cancellable,
+				G_CALLBACK (gdav_get_parallel_cancelled_cb),
+				g_object_ref (parallel_context->cancellable),
+				(GDestroyNotify) g_object_unref);
+	}
+
+	prop = gdav_property_set_new ();
+	gdav_property_set_add_type (
+		prop, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY);
+	gdav_property_set_add_type (
+		prop, GDAV_TYPE_GETETAG_PROPERTY);
+
+	gdav_propfind (
+		session, uri, GDAV_PROPFIND_PROP, prop,
+		GDAV_DEPTH_0, parallel_context->cancellable,
+		gdav_get_parallel_propfind_cb,
+		g_object_ref (task));
+
+	g_object_unref (prop);
+	g_object_unref (task);
+}
+
+gboolean
+gdav_get_parallel_finish (SoupSession *session,
+                          GAsyncResult *result,
+                          GError **error)
+{
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_get_parallel), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+/* The checkpoint file is small and local, so it's read and written
+ * synchronously.  Failing to write one costs the ability to resume,
+ * not the transfer, so those errors are ignored. */
+
+static GFile *
+gdav_checkpoint_new (GFile *file,
+                     GFile *checkpoint)
+{
+	GFile *parent;
+	gchar *basename;
+	gchar *checkpoint_name;
+
+	if (checkpoint != NULL)
+		return g_object_ref (checkpoint);
+
+	parent = g_file_get_parent (file);
+	basename = g_file_get_basename (file);
+	checkpoint_name = g_strconcat (basename, ".gdav-checkpoint", NULL);
+
+	if (parent != NULL)
+		checkpoint = g_file_get_child (parent, checkpoint_name);
+	else
+		checkpoint = g_file_new_for_path (checkpoint_name);
+
+	g_clear_object (&parent);
+	g_free (basename);
+	g_free (checkpoint_name);
+
+	return checkpoint;
+}
+
+static GKeyFile *
+gdav_checkpoint_load (GFile *checkpoint,
+                      SoupURI *uri)
+{
+	GKeyFile *key_file;
+	gchar *contents = NULL;
+	gchar *uri_string;
+	gchar *saved_uri;
+	gsize length = 0;
+	gboolean valid = FALSE;
+
+	if (!g_file_load_contents (
+		checkpoint, NULL, &contents, &length, NULL, NULL))
+		return NULL;
+
+	key_file = g_key_file_new ();
+
+	if (g_key_file_load_from_data (
+		key_file, contents, length, G_KEY_FILE_NONE, NULL)) {
+		uri_string = soup_uri_to_string (uri, FALSE);
+		saved_uri = g_key_file_get_string (
+			key_file, CHECKPOINT_GROUP, "URI", NULL);
+		valid = (g_strcmp0 (uri_string, saved_uri) == 0);
+		g_free (uri_string);
+		g_free (saved_uri);
+	}
+
+	g_free (contents);
+
+	if (!valid) {
+		g_key_file_free (key_file);
+		key_file = NULL;
+	}
+
+	return key_file;
+}
+
+static void
+gdav_checkpoint_save (ResumeContext *resume_context)
+{
+	GKeyFile *key_file;
+	gchar *uri_string;
+	gchar *contents;
+	gsize length;
+
+	key_file = g_key_file_new ();
+
+	uri_string = soup_uri_to_string (resume_context->uri, FALSE);
+	g_key_file_set_string (
+		key_file, CHECKPOINT_GROUP, "URI", uri_string);
+	g_free (uri_string);
+
+	g_key_file_set_string (
+		key_file, CHECKPOINT_GROUP, "ETag", resume_context->etag);
+	g_key_file_set_uint64 (
+		key_file, CHECKPOINT_GROUP, "Offset", resume_context->offset);
+
+	/* Only uploads know the local file's size up front. */
+	if (resume_context->input_stream != NULL) {
+		g_key_file_set_uint64 (
+			key_file, CHECKPOINT_GROUP,
+			"Size", resume_context->size);
+		g_key_file_set_uint64 (
+			key_file, CHECKPOINT_GROUP,
+			"Modified", resume_context->modified);
+	}
+
+	contents = g_key_file_to_data (key_file, &length, NULL);
+
+	g_file_replace_contents (
+		resume_context->checkpoint, contents, length,
+		NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL, NULL);
+
+	g_free (contents);
+	g_key_file_free (key_file);
+}
+
+static void
+gdav_checkpoint_clear (ResumeContext *resume_context)
+{
+	g_file_delete (resume_context->checkpoint, NULL, NULL);
+}
+
+gboolean
+gdav_get_resume_sync (SoupSession *session,
+                      SoupURI *uri,
+                      GFile *file,
+                      GFile *checkpoint,
+                      SoupMessage **out_message,
+                      GCancellable *cancellable,
+                      GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_get_resume (
+		session, uri, file, checkpoint, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_get_resume_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+/* Called from the copy loop as the body is written to the file. */
+static void
+gdav_get_resume_progress (ResumeContext *resume_context,
+                          GOutputStream *output_stream,
+                          gsize n_written)
+{
+	resume_context->offset += n_written;
+
+	if (!resume_context->checkpointing)
+		return;
+
+	if (resume_context->offset < resume_context->next_checkpoint)
+		return;
+
+	/* Everything the checkpoint claims must be in the file. */
+	if (g_output_stream_flush (output_stream, NULL, NULL))
+		gdav_checkpoint_save (resume_context);
+
+	resume_context->next_checkpoint =
+		resume_context->offset + RESUME_CHECKPOINT_INTERVAL;
+}
+
+static void
+gdav_get_resume_copy_cb (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GOutputStream *output_stream;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	output_stream = g_io_stream_get_output_stream (
+		G_IO_STREAM (resume_context->io_stream));
+
+	g_task_propagate_boolean (G_TASK (result), &local_error);
+
+	if (local_error == NULL) {
+		g_io_stream_close (
+			G_IO_STREAM (resume_context->io_stream),
+			NULL, &local_error);
+	} else if (resume_context->checkpointing) {
+		if (g_output_stream_flush (output_stream, NULL, NULL))
+			gdav_checkpoint_save (resume_context);
+	}
+
+	if (local_error == NULL) {
+		gdav_checkpoint_clear (resume_context);
+		g_task_return_boolean (task, TRUE);
+	} else {
+		g_io_stream_close (
+			G_IO_STREAM (resume_context->io_stream),
+			NULL, NULL);
+		g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+static void	gdav_get_resume_send		(GTask *task);
+static void	gdav_get_resume_open		(GTask *task);
+
+static void
+gdav_get_resume_send_cb (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GetContext *get_context;
+	SoupMessage *message;
+	SoupSession *session;
+	GInputStream *input_stream;
+	goffset start = 0;
+	goffset end = 0;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+	message = resume_context->message;
+
+	input_stream = soup_request_send_finish (
+		SOUP_REQUEST (source_object), result, &local_error);
+
+	if (input_stream == NULL) {
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	if (message->status_code == SOUP_STATUS_PARTIAL_CONTENT) {
+		if (!soup_message_headers_get_content_range (
+			message->response_headers, &start, &end, NULL) ||
+		    start != resume_context->offset)
+			local_error = g_error_new_literal (
+				G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+				_("Server returned the wrong byte range"));
+
+	} else if (message->status_code ==
+		   SOUP_STATUS_REQUESTED_RANGE_NOT_SATISFIABLE &&
+		   resume_context->offset > 0) {
+		/* The resource shrank.  Start over. */
+		gdav_input_stream_drain (input_stream);
+		g_object_unref (input_stream);
+
+		resume_context->offset = 0;
+		gdav_get_resume_send (task);
+
+		g_object_unref (task);
+		return;
+
+	} else if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code)) {
+		/* The resource changed or the server ignored
+		 * the Range header.  Either way, start over. */
+		resume_context->offset = 0;
+
+	} else {
+		local_error = g_error_new (
+			SOUP_HTTP_ERROR, message->status_code,
+			"%s", message->reason_phrase);
+	}
+
+	/* Don't touch the file unless we have a body for it. */
+	if (local_error != NULL) {
+		gdav_input_stream_drain (input_stream);
+		g_object_unref (input_stream);
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	get_context = g_slice_new0 (GetContext);
+	get_context->message = g_object_ref (message);
+	get_context->input_stream = input_stream;
+	get_context->resume = resume_context;
+
+	/* Have the copy loop check the byte count. */
+	if (message->status_code == SOUP_STATUS_PARTIAL_CONTENT) {
+		get_context->range_start = start;
+		get_context->range_length = end - start + 1;
+	}
+
+	session = soup_request_get_session (SOUP_REQUEST (source_object));
+	get_context->capture_body =
+		(message->response_body->length == 0) &&
+		(soup_session_get_feature (session, SOUP_TYPE_LOGGER) != NULL);
+
+	resume_context->get_context = get_context;
+
+	gdav_get_resume_open (task);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_resume_send (GTask *task)
+{
+	ResumeContext *resume_context;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	request = gdav_request_get_uri (
+		resume_context->session,
+		resume_context->uri, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request == NULL) {
+		g_task_return_error (task, local_error);
+		return;
+	}
+
+	g_clear_object (&resume_context->message);
+	resume_context->message = soup_request_http_get_message (request);
+
+	/* If-Range makes the server send the whole entity
+	 * instead of a range if the entity tag has changed. */
+	if (resume_context->offset > 0) {
+		SoupMessageHeaders *headers;
+
+		headers = resume_context->message->request_headers;
+
+		soup_message_headers_set_range (
+			headers, resume_context->offset, -1);
+		soup_message_headers_append (
+			headers, "If-Range", resume_context->etag);
+	}
+
+	soup_request_send_async (
+		SOUP_REQUEST (request),
+		g_task_get_cancellable (task),
+		gdav_get_resume_send_cb,
+		g_object_ref (task));
+
+	g_object_unref (request);
+}
+
+static void
+gdav_get_resume_opened (GTask *task,
+                        GFileIOStream *io_stream,
+                        GError *local_error)
+{
+	GTask *copy_task;
+	ResumeContext *resume_context;
+	GetContext *get_context;
+	const gchar *etag;
+
+	resume_context = g_task_get_task_data (task);
+
+	get_context = resume_context->get_context;
+	resume_context->get_context = NULL;
+
+	resume_context->io_stream = io_stream;
+
+	if (local_error == NULL)
+		g_seekable_seek (
+			G_SEEKABLE (resume_context->io_stream),
+			resume_context->offset, G_SEEK_SET,
+			NULL, &local_error);
+
+	/* Drop whatever was written past the last checkpoint,
+	 * or the old content if we're starting over. */
+	if (local_error == NULL)
+		g_seekable_truncate (
+			G_SEEKABLE (resume_context->io_stream),
+			resume_context->offset, NULL, &local_error);
+
+	if (local_error != NULL) {
+		gdav_input_stream_drain (get_context->input_stream);
+		get_context_free (get_context);
+		if (resume_context->io_stream != NULL)
+			g_io_stream_close (
+				G_IO_STREAM (resume_context->io_stream),
+				NULL, NULL);
+		g_task_return_error (task, local_error);
+		return;
+	}
+
+	/* Without a strong entity tag there's no safe way to
+	 * resume, so don't leave a checkpoint behind. */
+	etag = soup_message_headers_get_one (
+		get_context->message->response_headers, "ETag");
+
+	g_free (resume_context->etag);
+	resume_context->etag = g_strdup (etag);
+
+	resume_context->checkpointing =
+		(etag != NULL) && !g_str_has_prefix (etag, "W/");
+
+	if (resume_context->checkpointing) {
+		gdav_checkpoint_save (resume_context);
+		resume_context->next_checkpoint =
+			resume_context->offset + RESUME_CHECKPOINT_INTERVAL;
+	} else {
+		gdav_checkpoint_clear (resume_context);
+	}
+
+	get_context->output_stream = g_object_ref (
+		g_io_stream_get_output_stream (
+		G_IO_STREAM (resume_context->io_stream)));
+
+	copy_task = g_task_new (
+		resume_context->session, g_task_get_cancellable (task),
+		gdav_get_resume_copy_cb, g_object_ref (task));
+	g_task_set_source_tag (copy_task, gdav_get_resume);
+
+	g_task_set_task_data (
+		copy_task, get_context,
+		(GDestroyNotify) get_context_free);
+
+	gdav_get_read (copy_task);
+
+	g_object_unref (copy_task);
+}
+
+static void
+gdav_get_resume_create_cb (GObject *source_object,
+                           GAsyncResult *result,
+                           gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GFileIOStream *io_stream;
+	GError *local_error = NULL;
+
+	io_stream = g_file_create_readwrite_finish (
+		G_FILE (source_object), result, &local_error);
+
+	gdav_get_resume_opened (task, io_stream, local_error);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_resume_open_cb (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GFileIOStream *io_stream;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	io_stream = g_file_open_readwrite_finish (
+		G_FILE (source_object), result, &local_error);
+
+	if (g_error_matches (local_error, G_IO_ERROR, G_IO_ERROR_NOT_FOUND)) {
+		g_clear_error (&local_error);
+
+		if (resume_context->offset > 0) {
+			/* The partial file vanished while we
+			 * were waiting on the server.  Start over. */
+			gdav_input_stream_drain (
+				resume_context->get_context->input_stream);
+			get_context_free (resume_context->get_context);
+			resume_context->get_context = NULL;
+
+			resume_context->offset = 0;
+			gdav_get_resume_send (task);
+		} else {
+			g_file_create_readwrite_async (
+				resume_context->file,
+				G_FILE_CREATE_NONE, G_PRIORITY_DEFAULT,
+				g_task_get_cancellable (task),
+				gdav_get_resume_create_cb,
+				g_object_ref (task));
+		}
+
+		g_object_unref (task);
+		return;
+	}
+
+	gdav_get_resume_opened (task, io_stream, local_error);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_get_resume_open (GTask *task)
+{
+	ResumeContext *resume_context;
+
+	resume_context = g_task_get_task_data (task);
+
+	/* Write to the file in place rather than through
+	 * g_file_replace(), which writes to a temporary file
+	 * and renames it on close.  A checkpoint has to
+	 * describe what is actually in the file. */
+	g_file_open_readwrite_async (
+		resume_context->file,
+		G_PRIORITY_DEFAULT,
+		g_task_get_cancellable (task),
+		gdav_get_resume_open_cb,
+		g_object_ref (task));
+}
+
+/**
+ * gdav_get_resume:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @file: a #GFile to download to
+ * @checkpoint: a #GFile to record progress in, or %NULL
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Like gdav_get(), but downloads to @file and can pick up where an
+ * earlier, interrupted call left off.
+ *
+ * Progress is recorded in @checkpoint as the download proceeds.  If
+ * @checkpoint is %NULL, a file named after @file with a ".gdav-checkpoint"
+ * suffix is used.  If a checkpoint for @uri exists, only the rest of
+ * the resource is requested with a Range header.  An If-Range header
+ * with the recorded entity tag makes the server send the whole
+ * resource instead if it has changed, and @file is then rewritten from
+ * the start.  The checkpoint is removed once the download completes.
+ *
+ * @file is not created or truncated until the server has answered with
+ * a successful status, so an error response leaves an existing @file
+ * alone.  After that it is written in place rather than replaced, so
+ * a failed download leaves partial content behind for the next call
+ * to pick up.
+ *
+ * Resuming requires the server to report a strong entity tag.  Without
+ * one no checkpoint is kept.
+ **/
+void
+gdav_get_resume (SoupSession *session,
+                 SoupURI *uri,
+                 GFile *file,
+                 GFile *checkpoint,
+                 GCancellable *cancellable,
+                 GAsyncReadyCallback callback,
+                 gpointer user_data)
+{
+	GTask *task;
+	ResumeContext *resume_context;
+	GKeyFile *key_file;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_FILE (file));
+	g_return_if_fail (checkpoint == NULL || G_IS_FILE (checkpoint));
+
+	resume_context = g_slice_new0 (ResumeContext);
+	resume_context->session = g_object_ref (session);
+	resume_context->uri = soup_uri_copy (uri);
+	resume_context->file = g_object_ref (file);
+	resume_context->checkpoint = gdav_checkpoint_new (file, checkpoint);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_get_resume);
+
+	g_task_set_task_data (
+		task, resume_context,
+		(GDestroyNotify) resume_context_free);
+
+	key_file = gdav_checkpoint_load (resume_context->checkpoint, uri);
+
+	if (key_file != NULL) {
+		resume_context->etag = g_key_file_get_string (
+			key_file, CHECKPOINT_GROUP, "ETag", NULL);
+		resume_context->offset = g_key_file_get_uint64 (
+			key_file, CHECKPOINT_GROUP, "Offset", NULL);
+		g_key_file_free (key_file);
+
+		if (resume_context->etag == NULL)
+			resume_context->offset = 0;
+	}
+
+	/* Don't trust the checkpoint beyond what's on disk.
+	 * This is just a stat(), not worth going async for. */
+	if (resume_context->offset > 0) {
+		GFileInfo *file_info;
+
+		file_info = g_file_query_info (
+			file, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+			G_FILE_QUERY_INFO_NONE, cancellable, NULL);
+
+		if (file_info != NULL) {
+			resume_context->offset = MIN (
+				resume_context->offset,
+				g_file_info_get_size (file_info));
+			g_object_unref (file_info);
+		} else {
+			resume_context->offset = 0;
+		}
+	}
+
+	/* The file is only opened once the server has
+	 * answered, so an error leaves it untouched. */
+	gdav_get_resume_send (task);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_get_resume_finish (SoupSession *session,
+                        GAsyncResult *result,
+                        SoupMessage **out_message,
+                        GError **error)
+{
+	ResumeContext *resume_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_get_resume), FALSE);
+
+	resume_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = resume_context->message;
+		resume_context->message = NULL;
+	}
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+gboolean
+gdav_put_sync (SoupSession *session,
+               SoupURI *uri,
+               GInputStream *input_stream,
+               goffset content_length,
+               const gchar *content_type,
+               const gchar *if_match,
+               GDavPutFlags flags,
+               gchar **out_etag,
+               SoupMessage **out_message,
+               GCancellable *cancellable,
+               GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (G_IS_INPUT_STREAM (input_stream), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_put (
+		session, uri, input_stream, content_length,
+		content_type, if_match, flags, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_put_finish (
+		session, result, out_etag, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void
+gdav_put_maybe_return (GTask *task)
+{
+	PutContext *put_context;
+	SoupMessage *message;
+
+	put_context = g_task_get_task_data (task);
+	message = put_context->message;
+
+	/* Wait for the message to finish and for any read
+	 * in progress to complete so the caller gets their
+	 * input stream back with nothing pending on it. */
+	if (!put_context->finished || put_context->reading)
+		return;
+
+	if (put_context->error != NULL) {
+		g_task_return_error (task, put_context->error);
+		put_context->error = NULL;
+
+	} else if (!g_task_return_error_if_cancelled (task)) {
+		if (SOUP_STATUS_IS_SUCCESSFUL (message->status_code)) {
+			put_context->etag = g_strdup (
+				soup_message_headers_get_one (
+				message->response_headers, "ETag"));
+			g_task_return_boolean (task, TRUE);
+		} else {
+			g_task_return_new_error (
+				task, SOUP_HTTP_ERROR,
+				message->status_code,
+				"%s", message->reason_phrase);
+		}
+	}
+}
+
+static void
+gdav_put_read_cb (GObject *source_object,
+                  GAsyncResult *result,
+                  gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	PutContext *put_context;
+	SoupMessage *message;
+	gpointer buffer;
+	gssize n_read;
+	GError *local_error = NULL;
+
+	put_context = g_task_get_task_data (task);
+	message = put_context->message;
+
+	buffer = put_context->buffer;
+	put_context->buffer = NULL;
+	put_context->reading = FALSE;
+
+	n_read = g_input_stream_read_finish (
+		G_INPUT_STREAM (source_object), result, &local_error);
+
+	if (n_read > 0)
+		put_context->n_read += n_read;
+
+	if (n_read == 0) {
+		put_context->eof = TRUE;
+
+		if (put_context->content_length >= 0 &&
+		    put_context->n_read != put_context->content_length)
+			local_error = g_error_new (
+				G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+				_("Input stream ended after %"
+				G_GOFFSET_FORMAT " of %"
+				G_GOFFSET_FORMAT " bytes"),
+				put_context->n_read,
+				put_context->content_length);
+
+	} else if (n_read > 0 &&
+		   put_context->content_length >= 0 &&
+		   put_context->n_read > put_context->content_length) {
+		local_error = g_error_new (
+			G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+			_("Input stream is longer than %"
+			G_GOFFSET_FORMAT " bytes"),
+			put_context->content_length);
+	}
+
+	if (put_context->finished) {
+		/* The server answered without waiting
+		 * for the rest of the body.  Drop it. */
+		g_clear_error (&local_error);
+		g_free (buffer);
+
+	} else if (local_error != NULL) {
+		g_free (buffer);
+		put_context->error = local_error;
+		soup_session_cancel_message (
+			put_context->session, message,
+			SOUP_STATUS_CANCELLED);
+
+	} else if (n_read > 0) {
+		soup_message_body_append (
+			message->request_body,
+			SOUP_MEMORY_TAKE, buffer, n_read);
+		soup_session_unpause_message (
+			put_context->session, message);
+
+	} else {
+		g_free (buffer);
+		soup_message_body_complete (message->request_body);
+		soup_session_unpause_message (
+			put_context->session, message);
+	}
+
+	gdav_put_maybe_return (task);
+
+	g_object_unref (task);
+}
+
+/* Called when libsoup is ready for more of the request body. */
+static void
+gdav_put_wrote_cb (SoupMessage *message,
+                   GTask *task)
+{
+	PutContext *put_context;
+
+	put_context = g_task_get_task_data (task);
+
+	if (put_context->reading || put_context->eof)
+		return;
+
+	put_context->reading = TRUE;
+	put_context->buffer = g_malloc (COPY_BUFFER_SIZE);
+
+	g_input_stream_read_async (
+		put_context->input_stream,
+		put_context->buffer,
+		COPY_BUFFER_SIZE,
+		G_PRIORITY_DEFAULT,
+		g_task_get_cancellable (task),
+		gdav_put_read_cb,
+		g_object_ref (task));
+}
+
+static void
+gdav_put_cancelled_cb (GCancellable *cancellable,
+                       PutContext *put_context)
+{
+	soup_session_cancel_message (
+		put_context->session,
+		put_context->message,
+		SOUP_STATUS_CANCELLED);
+}
+
+static void
+gdav_put_message_cb (SoupSession *session,
+                     SoupMessage *message,
+                     gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	PutContext *put_context;
+
+	put_context = g_task_get_task_data (task);
+
+	put_context->finished = TRUE;
+
+	g_signal_handlers_disconnect_by_func (
+		message, gdav_put_wrote_cb, task);
+
+	/* XXX g_cancellable_disconnect() deadlocks if we got
+	 *     here from within the "cancelled" signal emission,
+	 *     which happens if cancelling finishes the message
+	 *     synchronously. */
+	if (put_context->cancelled_handler_id > 0)
+		g_signal_handler_disconnect (
+			g_task_get_cancellable (task),
+			put_context->cancelled_handler_id);
+	put_context->cancelled_handler_id = 0;
+
+	gdav_put_maybe_return (task);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_put_start (GTask *task,
+                SoupURI *uri,
+                GInputStream *input_stream,
+                goffset content_length,
+                const gchar *content_type,
+                const gchar *if_match,
+                GDavPutFlags flags)
+{
+	PutContext *put_context;
+	SoupRequestHTTP *request;
+	GCancellable *cancellable;
+	GError *local_error = NULL;
+
+	put_context = g_task_get_task_data (task);
+	put_context->input_stream = g_object_ref (input_stream);
+	put_context->content_length = content_length;
+
+	request = gdav_request_put_uri (
+		put_context->session, uri, content_length,
+		content_type, if_match, flags, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request == NULL) {
+		g_task_return_error (task, local_error);
+		return;
+	}
+
+	put_context->message = soup_request_http_get_message (request);
+
+	g_object_unref (request);
+
+	/* XXX SoupRequest can't stream a request body, so this goes
+	 *     through soup_session_queue_message().  libsoup pauses
+	 *     the message whenever it runs out of body to send, and
+	 *     we feed it one buffer at a time from the input stream.
+	 *     Since written chunks are discarded, the message cannot
+	 *     be restarted once the body has started to go out, so
+	 *     settle authentication before sending large uploads. */
+	soup_message_body_set_accumulate (
+		put_context->message->request_body, FALSE);
+
+	g_signal_connect (
+		put_context->message, "wrote-headers",
+		G_CALLBACK (gdav_put_wrote_cb), task);
+
+	g_signal_connect (
+		put_context->message, "wrote-chunk",
+		G_CALLBACK (gdav_put_wrote_cb), task);
+
+	/* soup_session_queue_message() consumes a reference. */
+	soup_session_queue_message (
+		put_context->session,
+		g_object_ref (put_context->message),
+		gdav_put_message_cb,
+		g_object_ref (task));
+
+	cancellable = g_task_get_cancellable (task);
+
+	if (cancellable != NULL)
+		put_context->cancelled_handler_id = g_cancellable_connect (
+			cancellable,
+			G_CALLBACK (gdav_put_cancelled_cb),
+			put_context, (GDestroyNotify) NULL);
+
+	/* Already cancelled, and the message may have finished
+	 * before we had a handler ID to disconnect. */
+	if (put_context->finished && put_context->cancelled_handler_id > 0) {
+		g_cancellable_disconnect (
+			cancellable, put_context->cancelled_handler_id);
+		put_context->cancelled_handler_id = 0;
+	}
+}
+
+/**
+ * gdav_put:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @input_stream: a #GInputStream with the content to upload
+ * @content_length: the number of bytes in @input_stream, or -1 if unknown
+ * @content_type: the media type of the content, or %NULL
+ * @if_match: an entity tag the resource must currently have, or %NULL
+ * @flags: #GDavPutFlags
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Uploads the content of @input_stream to @uri, reading and sending one
+ * buffer at a time so memory use stays constant regardless of size.
+ * If @content_length is -1 the body is sent with chunked encoding.
+ *
+ * If @if_match is given, the upload only succeeds if the resource's
+ * current entity tag matches.  With %GDAV_PUT_FLAGS_NO_OVERWRITE it only
+ * succeeds if the resource does not exist yet.  Either precondition
+ * failing results in a %SOUP_STATUS_PRECONDITION_FAILED error.
+ **/
+void
+gdav_put (SoupSession *session,
+          SoupURI *uri,
+          GInputStream *input_stream,
+          goffset content_length,
+          const gchar *content_type,
+          const gchar *if_match,
+          GDavPutFlags flags,
+          GCancellable *cancellable,
+          GAsyncReadyCallback callback,
+          gpointer user_data)
+{
+	GTask *task;
+	PutContext *put_context;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_INPUT_STREAM (input_stream));
+
+	put_context = g_slice_new0 (PutContext);
+	put_context->session = g_object_ref (session);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_put);
+
+	g_task_set_task_data (
+		task, put_context, (GDestroyNotify) put_context_free);
+
+	gdav_put_start (
+		task, uri, input_stream, content_length,
+		content_type, if_match, flags);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_put_finish (SoupSession *session,
+                 GAsyncResult *result,
+                 gchar **out_etag,
+                 SoupMessage **out_message,
+                 GError **error)
+{
+	PutContext *put_context;
+	gboolean success;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_put) ||
+		g_async_result_is_tagged (result, gdav_put_file), FALSE);
+
+	put_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = put_context->message;
+		put_context->message = NULL;
+	}
+
+	success = g_task_propagate_boolean (G_TASK (result), error);
+
+	if (success && out_etag != NULL) {
+		*out_etag = put_context->etag;
+		put_context->etag = NULL;
+	}
+
+	return success;
+}
+
+gboolean
+gdav_put_file_sync (SoupSession *session,
+                    SoupURI *uri,
+                    GFile *file,
+                    const gchar *content_type,
+                    const gchar *if_match,
+                    GDavPutFlags flags,
+                    gchar **out_etag,
+                    SoupMessage **out_message,
+                    GCancellable *cancellable,
+                    GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_put_file (
+		session, uri, file, content_type,
+		if_match, flags, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_put_file_finish (
+		session, result, out_etag, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void
+gdav_put_file_read_cb (GObject *source_object,
+                       GAsyncResult *result,
+                       gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	PutContext *put_context;
+	GFileInputStream *input_stream;
+	GFileInfo *file_info;
+	goffset content_length = -1;
+	GError *local_error = NULL;
+
+	put_context = g_task_get_task_data (task);
+
+	input_stream = g_file_read_finish (
+		G_FILE (source_object), result, &local_error);
+
+	if (input_stream == NULL) {
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	/* This is just an fstat(), not worth going async for. */
+	file_info = g_file_input_stream_query_info (
+		input_stream, G_FILE_ATTRIBUTE_STANDARD_SIZE,
+		g_task_get_cancellable (task), NULL);
+
+	if (file_info != NULL) {
+		content_length = g_file_info_get_size (file_info);
+		g_object_unref (file_info);
+	}
+
+	gdav_put_start (
+		task, put_context->uri,
+		G_INPUT_STREAM (input_stream), content_length,
+		put_context->content_type, put_context->if_match,
+		put_context->flags);
+
+	g_object_unref (input_stream);
+
+	g_object_unref (task);
+}
+
+/**
+ * gdav_put_file:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @file: a #GFile with the content to upload
+ * @content_type: the media type of the content, or %NULL
+ * @if_match: an entity tag the resource must currently have, or %NULL
+ * @flags: #GDavPutFlags
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Like gdav_put(), but streams the content of @file and sends its size
+ * as the Content-Length when it can be determined.
+ **/
+void
+gdav_put_file (SoupSession *session,
+               SoupURI *uri,
+               GFile *file,
+               const gchar *content_type,
+               const gchar *if_match,
+               GDavPutFlags flags,
+               GCancellable *cancellable,
+               GAsyncReadyCallback callback,
+               gpointer user_data)
+{
+	GTask *task;
+	PutContext *put_context;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_FILE (file));
+
+	put_context = g_slice_new0 (PutContext);
+	put_context->session = g_object_ref (session);
+	put_context->uri = soup_uri_copy (uri);
+	put_context->content_type = g_strdup (content_type);
+	put_context->if_match = g_strdup (if_match);
+	put_context->flags = flags;
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_put_file);
+
+	g_task_set_task_data (
+		task, put_context, (GDestroyNotify) put_context_free);
+
+	g_file_read_async (
+		file, G_PRIORITY_DEFAULT, cancellable,
+		gdav_put_file_read_cb,
+		g_object_ref (task));
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_put_file_finish (SoupSession *session,
+                      GAsyncResult *result,
+                      gchar **out_etag,
+                      SoupMessage **out_message,
+                      GError **error)
+{
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_put_file), FALSE);
+
+	return gdav_put_finish (
+		session, result, out_etag, out_message, error);
+}
+
+gboolean
+gdav_put_resume_sync (SoupSession *session,
+                      SoupURI *uri,
+                      GFile *file,
+                      GFile *checkpoint,
+                      const gchar *content_type,
+                      gchar **out_etag,
+                      SoupMessage **out_message,
+                      GCancellable *cancellable,
+                      GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_put_resume (
+		session, uri, file, checkpoint, content_type,
+		cancellable, gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_put_resume_finish (
+		session, result, out_etag, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void	gdav_put_resume_read		(GTask *task);
+
+static void
+gdav_put_resume_verify_cb (GObject *source_object,
+                           GAsyncResult *result,
+                           gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GDavMultiStatus *multi_status;
+	GDavResponse *response = NULL;
+	const GValue *value = NULL;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	multi_status = gdav_propfind_finish (
+		SOUP_SESSION (source_object), result, NULL, &local_error);
+
+	if (multi_status != NULL) {
+		response = gdav_multi_status_get_response_by_href (
+			multi_status, resume_context->uri);
+		if (response == NULL)
+			response = gdav_multi_status_get_response (
+				multi_status, 0);
+	}
+
+	if (response != NULL)
+		value = gdav_response_peek_property (
+			response, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY, NULL);
+
+	/* A server that ignores Content-Range on PUT replaces
+	 * the resource with each segment instead of updating
+	 * the range, so the size won't match what we've sent. */
+	if (local_error == NULL &&
+	    (value == NULL ||
+	     g_value_get_uint64 (value) != (guint64) resume_context->offset))
+		local_error = g_error_new_literal (
+			G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Server does not support partial uploads"));
+
+	g_clear_object (&multi_status);
+
+	if (local_error == NULL &&
+	    resume_context->offset < resume_context->size) {
+		resume_context->range_checked = TRUE;
+		gdav_put_resume_read (task);
+	} else {
+		g_input_stream_close (
+			resume_context->input_stream, NULL, NULL);
+		gdav_checkpoint_clear (resume_context);
+
+		if (local_error == NULL)
+			g_task_return_boolean (task, TRUE);
+		else
+			g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+/* Checks the ranged segments sent so far landed in place. */
+static void
+gdav_put_resume_verify (GTask *task)
+{
+	ResumeContext *resume_context;
+	GDavPropertySet *prop;
+
+	resume_context = g_task_get_task_data (task);
+
+	prop = gdav_property_set_new ();
+	gdav_property_set_add_type (
+		prop, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY);
+
+	gdav_propfind (
+		resume_context->session, resume_context->uri,
+		GDAV_PROPFIND_PROP, prop, GDAV_DEPTH_0,
+		g_task_get_cancellable (task),
+		gdav_put_resume_verify_cb,
+		g_object_ref (task));
+
+	g_object_unref (prop);
+}
+
+static void
+gdav_put_resume_complete (GTask *task)
+{
+	ResumeContext *resume_context;
+
+	resume_context = g_task_get_task_data (task);
+
+	g_input_stream_close (
+		resume_context->input_stream, NULL, NULL);
+
+	gdav_checkpoint_clear (resume_context);
+	g_task_return_boolean (task, TRUE);
+}
+
+static void
+gdav_put_resume_segment_cb (GObject *source_object,
+                            GAsyncResult *result,
+                            gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GDavMultiStatus *multi_status = NULL;
+	const gchar *etag;
+	goffset segment_start;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	gdav_request_send_finish (
+		SOUP_REQUEST_HTTP (source_object), result, &local_error);
+
+	if (local_error == NULL)
+		gdav_message_check_status (
+			resume_context->message,
+			&multi_status, &local_error);
+
+	g_clear_object (&multi_status);
+
+	/* RFC 7231 Section 4.3.4 has servers that don't support
+	 * partial PUT reject Content-Range with 400 Bad Request. */
+	if (resume_context->ranged && (
+	    g_error_matches (
+		local_error, SOUP_HTTP_ERROR,
+		SOUP_STATUS_BAD_REQUEST) ||
+	    g_error_matches (
+		local_error, SOUP_HTTP_ERROR,
+		SOUP_STATUS_NOT_IMPLEMENTED))) {
+		g_clear_error (&local_error);
+		local_error = g_error_new_literal (
+			G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+			_("Server does not support partial uploads"));
+	}
+
+	if (local_error != NULL) {
+		/* Someone else changed the partial resource,
+		 * so the checkpoint is no good anymore. */
+		if (g_error_matches (
+			local_error, SOUP_HTTP_ERROR,
+			SOUP_STATUS_PRECONDITION_FAILED))
+			gdav_checkpoint_clear (resume_context);
+
+		g_input_stream_close (
+			resume_context->input_stream, NULL, NULL);
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	segment_start = resume_context->offset;
+	resume_context->offset += resume_context->n_buffered;
+	resume_context->n_buffered = 0;
+
+	etag = soup_message_headers_get_one (
+		resume_context->message->response_headers, "ETag");
+
+	g_free (resume_context->etag);
+	resume_context->etag = g_strdup (etag);
+
+	/* Without a strong entity tag the next attempt can't
+	 * tell whether the partial resource is still ours. */
+	if (etag != NULL && !g_str_has_prefix (etag, "W/"))
+		gdav_checkpoint_save (resume_context);
+	else
+		gdav_checkpoint_clear (resume_context);
+
+	/* A server that ignores Content-Range leaves a segment at
+	 * offset 0 looking just right, so check the first segment
+	 * that starts further in before sending any more, and the
+	 * whole resource once the last one is in. */
+	if (resume_context->ranged &&
+	    ((segment_start > 0 && !resume_context->range_checked) ||
+	     resume_context->offset >= resume_context->size))
+		gdav_put_resume_verify (task);
+	else if (resume_context->offset < resume_context->size)
+		gdav_put_resume_read (task);
+	else
+		gdav_put_resume_complete (task);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_put_resume_send (GTask *task)
+{
+	ResumeContext *resume_context;
+	SoupRequestHTTP *request;
+	SoupMessage *message;
+	const gchar *if_match = NULL;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	/* Each segment after the first must land on the
+	 * partial resource we left there, and nothing else. */
+	if (resume_context->offset > 0 && resume_context->etag != NULL &&
+	    !g_str_has_prefix (resume_context->etag, "W/"))
+		if_match = resume_context->etag;
+
+	request = gdav_request_put_uri (
+		resume_context->session, resume_context->uri,
+		resume_context->n_buffered, resume_context->content_type,
+		if_match, GDAV_PUT_FLAGS_NONE, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request == NULL) {
+		g_input_stream_close (
+			resume_context->input_stream, NULL, NULL);
+		g_task_return_error (task, local_error);
+		return;
+	}
+
+	message = soup_request_http_get_message (request);
+
+	g_clear_object (&resume_context->message);
+	resume_context->message = message;
+
+	/* A file that fits in one segment is a plain PUT. */
+	if (resume_context->offset > 0 ||
+	    resume_context->n_buffered < resume_context->size) {
+		soup_message_headers_set_content_range (
+			message->request_headers,
+			resume_context->offset,
+			resume_context->offset +
+			resume_context->n_buffered - 1,
+			resume_context->size);
+		resume_context->ranged = TRUE;
+	}
+
+	soup_message_body_append (
+		message->request_body, SOUP_MEMORY_TAKE,
+		resume_context->buffer, resume_context->n_buffered);
+	resume_context->buffer = NULL;
+
+	gdav_request_send (
+		request, g_task_get_cancellable (task),
+		gdav_put_resume_segment_cb,
+		g_object_ref (task));
+
+	g_object_unref (request);
+}
+
+static void
+gdav_put_resume_read_cb (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	goffset remaining;
+	gssize n_read;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	n_read = g_input_stream_read_finish (
+		G_INPUT_STREAM (source_object), result, &local_error);
+
+	remaining = resume_context->size - resume_context->offset;
+
+	if (n_read == 0 && resume_context->n_buffered < remaining)
+		local_error = g_error_new_literal (
+			G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+			_("File changed during upload"));
+
+	if (local_error != NULL) {
+		g_input_stream_close (
+			resume_context->input_stream, NULL, NULL);
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	resume_context->n_buffered += n_read;
+
+	if (resume_context->n_buffered < MIN (remaining, RESUME_SEGMENT_SIZE))
+		gdav_put_resume_read (task);
+	else
+		gdav_put_resume_send (task);
+
+	g_object_unref (task);
+}
+
+/* Fills the buffer with the next segment of the file. */
+static void
+gdav_put_resume_read (GTask *task)
+{
+	ResumeContext *resume_context;
+	goffset remaining;
+	gsize segment_size;
+
+	resume_context = g_task_get_task_data (task);
+
+	remaining = resume_context->size - resume_context->offset;
+	segment_size = MIN (remaining, RESUME_SEGMENT_SIZE);
+
+	/* An empty file still needs one (empty) PUT. */
+	if (segment_size == 0) {
+		gdav_put_resume_send (task);
+		return;
+	}
+
+	if (resume_context->buffer == NULL)
+		resume_context->buffer = g_malloc (RESUME_SEGMENT_SIZE);
+
+	g_input_stream_read_async (
+		resume_context->input_stream,
+		resume_context->buffer + resume_context->n_buffered,
+		segment_size - resume_context->n_buffered,
+		G_PRIORITY_DEFAULT,
+		g_task_get_cancellable (task),
+		gdav_put_resume_read_cb,
+		g_object_ref (task));
+}
+
+static void
+gdav_put_resume_propfind_cb (GObject *source_object,
+                             GAsyncResult *result,
+                             gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GDavMultiStatus *multi_status;
+	GDavResponse *response = NULL;
+	const GValue *length_value = NULL;
+	const GValue *etag_value = NULL;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	/* Errors here just mean we can't resume. */
+	multi_status = gdav_propfind_finish (
+		SOUP_SESSION (source_object), result, NULL, NULL);
+
+	if (multi_status != NULL) {
+		response = gdav_multi_status_get_response_by_href (
+			multi_status, resume_context->uri);
+		if (response == NULL)
+			response = gdav_multi_status_get_response (
+				multi_status, 0);
+	}
+
+	if (response != NULL) {
+		length_value = gdav_response_peek_property (
+			response, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY, NULL);
+		etag_value = gdav_response_peek_property (
+			response, GDAV_TYPE_GETETAG_PROPERTY, NULL);
+	}
+
+	/* Resume only if the partial resource
+	 * is exactly as we left it. */
+	if (length_value == NULL || etag_value == NULL ||
+	    g_value_get_uint64 (length_value) !=
+	    (guint64) resume_context->offset ||
+	    g_strcmp0 (g_value_get_string (etag_value),
+	    resume_context->etag) != 0)
+		resume_context->offset = 0;
+
+	g_clear_object (&multi_status);
+
+	if (resume_context->offset > 0) {
+		resume_context->ranged = TRUE;
+		g_seekable_seek (
+			G_SEEKABLE (resume_context->input_stream),
+			resume_context->offset, G_SEEK_SET,
+			NULL, &local_error);
+	}
+
+	if (local_error != NULL) {
+		g_input_stream_close (
+			resume_context->input_stream, NULL, NULL);
+		g_task_return_error (task, local_error);
+	} else {
+		gdav_put_resume_read (task);
+	}
+
+	g_object_unref (task);
+}
+
+static void
+gdav_put_resume_open_cb (GObject *source_object,
+                         GAsyncResult *result,
+                         gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	ResumeContext *resume_context;
+	GFileInputStream *input_stream;
+	GFileInfo *file_info;
+	GKeyFile *key_file;
+	GError *local_error = NULL;
+
+	resume_context = g_task_get_task_data (task);
+
+	input_stream = g_file_read_finish (
+		G_FILE (source_object), result, &local_error);
+
+	if (input_stream == NULL) {
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	resume_context->input_stream = G_INPUT_STREAM (input_stream);
+
+	/* This is just an fstat(), not worth going async for. */
+	file_info = g_file_input_stream_query_info (
+		input_stream,
+		G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+		G_FILE_ATTRIBUTE_TIME_MODIFIED,
+		g_task_get_cancellable (task), &local_error);
+
+	if (file_info == NULL) {
+		g_input_stream_close (
+			resume_context->input_stream, NULL, NULL);
+		g_task_return_error (task, local_error);
+		g_object_unref (task);
+		return;
+	}
+
+	resume_context->size = g_file_info_get_size (file_info);
+	resume_context->modified = g_file_info_get_attribute_uint64 (
+		file_info, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+	g_object_unref (file_info);
+
+	key_file = gdav_checkpoint_load (
+		resume_context->checkpoint, resume_context->uri);
+
+	/* The checkpoint only counts if the local
+	 * file hasn't changed since it was written. */
+	if (key_file != NULL &&
+	    g_key_file_get_uint64 (key_file, CHECKPOINT_GROUP,
+	    "Size", NULL) == (guint64) resume_context->size &&
+	    g_key_file_get_uint64 (key_file, CHECKPOINT_GROUP,
+	    "Modified", NULL) == resume_context->modified) {
+		resume_context->etag = g_key_file_get_string (
+			key_file, CHECKPOINT_GROUP, "ETag", NULL);
+		resume_context->offset = g_key_file_get_uint64 (
+			key_file, CHECKPOINT_GROUP, "Offset", NULL);
+	}
+
+	if (key_file != NULL)
+		g_key_file_free (key_file);
+
+	if (resume_context->etag != NULL &&
+	    resume_context->offset > 0 &&
+	    resume_context->offset < resume_context->size) {
+		GDavPropertySet *prop;
+
+		prop = gdav_property_set_new ();
+		gdav_property_set_add_type (
+			prop, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY);
+		gdav_property_set_add_type (
+			prop, GDAV_TYPE_GETETAG_PROPERTY);
+
+		gdav_propfind (
+			resume_context->session, resume_context->uri,
+			GDAV_PROPFIND_PROP, prop, GDAV_DEPTH_0,
+			g_task_get_cancellable (task),
+			gdav_put_resume_propfind_cb,
+			g_object_ref (task));
+
+		g_object_unref (prop);
+	} else {
+		resume_context->offset = 0;
+		gdav_put_resume_read (task);
+	}
+
+	g_object_unref (task);
+}
+
+/**
+ * gdav_put_resume:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @file: a #GFile with the content to upload
+ * @checkpoint: a #GFile to record progress in, or %NULL
+ * @content_type: the media type of the content, or %NULL
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Uploads @file to @uri in segments, and can pick up where an earlier,
+ * interrupted call left off.  This needs a server that accepts PUT
+ * requests with a Content-Range header as partial updates.  A file
+ * that fits in a single segment is sent as a plain PUT.
+ *
+ * After each segment, progress and the partial resource's entity tag
+ * are recorded in @checkpoint.  If @checkpoint is %NULL, a file named
+ * after @file with a ".gdav-checkpoint" suffix is used.  A checkpoint
+ * is only used if @file has not changed since, and the partial resource
+ * still has the recorded size and entity tag.  Later segments are sent
+ * with If-Match, so another client changing the resource stops the
+ * upload.  The checkpoint is removed once the upload completes.
+ *
+ * The resource size is checked after the first segment that doesn't
+ * start at offset 0, and again at the end.  If the server rejects
+ * Content-Range, or ignores it and replaces the resource instead, the
+ * operation fails with %G_IO_ERROR_NOT_SUPPORTED at that point.  Note
+ * that a fresh upload's first segment carries no precondition, so on
+ * a server that ignores Content-Range it replaces any existing resource
+ * at @uri with just that segment.
+ **/
+void
+gdav_put_resume (SoupSession *session,
+                 SoupURI *uri,
+                 GFile *file,
+                 GFile *checkpoint,
+                 const gchar *content_type,
+                 GCancellable *cancellable,
+                 GAsyncReadyCallback callback,
+                 gpointer user_data)
+{
+	GTask *task;
+	ResumeContext *resume_context;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (G_IS_FILE (file));
+	g_return_if_fail (checkpoint == NULL || G_IS_FILE (checkpoint));
+
+	resume_context = g_slice_new0 (ResumeContext);
+	resume_context->session = g_object_ref (session);
+	resume_context->uri = soup_uri_copy (uri);
+	resume_context->file = g_object_ref (file);
+	resume_context->checkpoint = gdav_checkpoint_new (file, checkpoint);
+	resume_context->content_type = g_strdup (content_type);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_put_resume);
+
+	g_task_set_task_data (
+		task, resume_context,
+		(GDestroyNotify) resume_context_free);
+
+	g_file_read_async (
+		file, G_PRIORITY_DEFAULT, cancellable,
+		gdav_put_resume_open_cb,
+		g_object_ref (task));
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_put_resume_finish (SoupSession *session,
+                        GAsyncResult *result,
+                        gchar **out_etag,
+                        SoupMessage **out_message,
+                        GError **error)
+{
+	ResumeContext *resume_context;
+	gboolean success;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_put_resume), FALSE);
+
+	resume_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = resume_context->message;
+		resume_context->message = NULL;
+	}
+
+	success = g_task_propagate_boolean (G_TASK (result), error);
+
+	if (success && out_etag != NULL) {
+		*out_etag = resume_context->etag;
+		resume_context->etag = NULL;
+	}
+
+	return success;
+}
+
+GDavMultiStatus *
+gdav_propfind_sync (SoupSession *session,
+                    SoupURI *uri,
+                    GDavPropFindType type,
+                    GDavPropertySet *prop,
+                    GDavDepth depth,
+                    SoupMessage **out_message,
+                    GCancellable *cancellable,
+                    GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	GDavMultiStatus *multi_status;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_propfind (
+		session, uri, type, prop, depth, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	multi_status = gdav_propfind_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return multi_status;
+}
+
+static void
+gdav_multi_status_request_cb (GObject *source_object,
+                              GAsyncResult *result,
+                              gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GDavMultiStatus *multi_status;
+	GError *local_error = NULL;
+
+	multi_status = gdav_request_parse_finish (
+		SOUP_REQUEST_HTTP (source_object), result, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((multi_status != NULL) && (local_error == NULL)) ||
+		((multi_status == NULL) && (local_error != NULL)));
+
+	if (multi_status != NULL)
+		g_task_return_pointer (task, multi_status, g_object_unref);
+
+	if (local_error != NULL)
+		g_task_return_error (task, local_error);
+
+	g_object_unref (task);
+}
+
+/**
+ * gdav_propfind:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI
+ * @type: a #GDavPropFindType
+ * @prop: a #GDavPropertySet, or %NULL
+ * @depth: a #GDavDepth
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Sends a PROPFIND request for @uri.  The multistatus response is
+ * parsed while it downloads rather than after it is complete.
+ *
+ * Because of that, the response body is only kept in the #SoupMessage
+ * returned by gdav_propfind_finish(), and #SoupMessage::finished is
+ * only emitted, if a #SoupLogger is attached to @session for debugging.
+ * Read results from the returned #GDavMultiStatus instead.
+ **/
+void
+gdav_propfind (SoupSession *session,
+               SoupURI *uri,
+               GDavPropFindType type,
+               GDavPropertySet *prop,
+               GDavDepth depth,
+               GCancellable *cancellable,
+               GAsyncReadyCallback callback,
+               gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+
+	async_context = g_slice_new0 (AsyncContext);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_propfind);
+
+	g_task_set_task_data (
+		task, async_context, (GDestroyNotify) async_context_free);
+
+	request = gdav_request_propfind_uri (
+		session, uri, type, prop, depth, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request != NULL) {
+		async_context->message =
+			soup_request_http_get_message (request);
+
+		gdav_request_parse (
+			request, NULL, NULL, cancellable,
+			gdav_multi_status_request_cb,
+			g_object_ref (task));
+
+		g_object_unref (request);
+	} else {
+		g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+GDavMultiStatus *
+gdav_propfind_finish (SoupSession *session,
+                      GAsyncResult *result,
+                      SoupMessage **out_message,
+                      GError **error)
+{
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), NULL);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_propfind), FALSE);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = async_context->message;
+		async_context->message = NULL;
+	}
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+
+gboolean
+gdav_propfind_foreach_sync (SoupSession *session,
+                            SoupURI *uri,
+                            GDavPropFindType type,
+                            GDavPropertySet *prop,
+                            GDavDepth depth,
+                            GDavResponseFunc func,
+                            gpointer func_data,
+                            SoupMessage **out_message,
+                            GCancellable *cancellable,
+                            GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_propfind_foreach (
+		session, uri, type, prop, depth,
+		func, func_data, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_propfind_foreach_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void
+gdav_propfind_foreach_request_cb (GObject *source_object,
+                                  GAsyncResult *result,
+                                  gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	GDavMultiStatus *multi_status;
+	GError *local_error = NULL;
+
+	/* All the responses went to the callback, so the
+	 * GDavMultiStatus only holds top-level bits like the
+	 * response description.  Nothing to return there. */
+	multi_status = gdav_request_parse_finish (
+		SOUP_REQUEST_HTTP (source_object), result, &local_error);
+
+	if (multi_status != NULL) {
+		g_task_return_boolean (task, TRUE);
+		g_object_unref (multi_status);
+	} else {
+		g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+void
+gdav_propfind_foreach (SoupSession *session,
+                       SoupURI *uri,
+                       GDavPropFindType type,
+                       GDavPropertySet *prop,
+                       GDavDepth depth,
+                       GDavResponseFunc func,
+                       gpointer func_data,
+                       GCancellable *cancellable,
+                       GAsyncReadyCallback callback,
+                       gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (func != NULL);
+
+	async_context = g_slice_new0 (AsyncContext);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_propfind_foreach);
+
+	g_task_set_task_data (
+		task, async_context, (GDestroyNotify) async_context_free);
+
+	request = gdav_request_propfind_uri (
+		session, uri, type, prop, depth, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request != NULL) {
+		async_context->message =
+			soup_request_http_get_message (request);
+
+		gdav_request_parse (
+			request, func, func_data, cancellable,
+			gdav_propfind_foreach_request_cb,
+			g_object_ref (task));
+
+		g_object_unref (request);
+	} else {
+		g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_propfind_foreach_finish (SoupSession *session,
+                              GAsyncResult *result,
+                              SoupMessage **out_message,
+                              GError **error)
+{
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (
+		result, gdav_propfind_foreach), FALSE);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = async_context->message;
+		async_context->message = NULL;
+	}
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+GDavListing *
+gdav_propfind_listing_sync (SoupSession *session,
+                            SoupURI *uri,
+                            GDavDepth depth,
+                            SoupMessage **out_message,
+                            GCancellable *cancellable,
+                            GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	GDavListing *listing;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_propfind_listing (
+		session, uri, depth, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	listing = gdav_propfind_listing_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return listing;
+}
+
+static gboolean
+gdav_propfind_listing_response_cb (GDavResponse *response,
+                                   gpointer user_data)
+{
+	gdav_listing_append_response (GDAV_LISTING (user_data), response);
+
+	return TRUE;
+}
+
+static void
+gdav_propfind_listing_foreach_cb (GObject *source_object,
+                                  GAsyncResult *result,
+                                  gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	async_context = g_task_get_task_data (task);
+
+	gdav_propfind_foreach_finish (
+		SOUP_SESSION (source_object), result,
+		&async_context->message, &local_error);
+
+	if (local_error != NULL) {
+		g_task_return_error (task, local_error);
+	} else {
+		g_task_return_pointer (
+			task, g_object_ref (async_context->listing),
+			(GDestroyNotify) g_object_unref);
+	}
+
+	g_object_unref (task);
+}
+
+void
+gdav_propfind_listing (SoupSession *session,
+                       SoupURI *uri,
+                       GDavDepth depth,
+                       GCancellable *cancellable,
+                       GAsyncReadyCallback callback,
+                       gpointer user_data)
+{
+	GTask *task;
+	AsyncContext *async_context;
+	GDavPropertySet *prop;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+
+	async_context = g_slice_new0 (AsyncContext);
+	async_context->listing = gdav_listing_new ();
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_propfind_listing);
+
+	g_task_set_task_data (
+		task, async_context, (GDestroyNotify) async_context_free);
+
+	prop = gdav_listing_new_property_set ();
+
+	/* Rows are appended as responses arrive, so the
+	 * full GDavMultiStatus tree is never built. */
+	gdav_propfind_foreach (
+		session, uri, GDAV_PROPFIND_PROP, prop, depth,
+		gdav_propfind_listing_response_cb,
+		async_context->listing, cancellable,
+		gdav_propfind_listing_foreach_cb,
+		g_object_ref (task));
+
+	g_object_unref (prop);
+
+	g_object_unref (task);
+}
+
+GDavListing *
+gdav_propfind_listing_finish (SoupSession *session,
+                              GAsyncResult *result,
+                              SoupMessage **out_message,
+                              GError **error)
+{
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), NULL);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (
+		result, gdav_propfind_listing), NULL);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = async_context->message;
+		async_context->message = NULL;
+	}
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+gboolean
+gdav_crawl_sync (SoupSession *session,
+                 SoupURI *uri,
+                 GDavPropertySet *prop,
+                 guint max_concurrent,
+                 GDavResponseFunc func,
+                 gpointer func_data,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_crawl (
+		session, uri, prop, max_concurrent,
+		func, func_data, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_crawl_finish (session, result, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void	gdav_crawl_dispatch		(GTask *task);
+
+static gboolean
+gdav_crawl_response_cb (GDavResponse *response,
+                        gpointer user_data)
+{
+	CrawlVisit *visit = user_data;
+	CrawlContext *crawl_context;
+	const GValue *value;
+	SoupURI *uri;
+	gchar *key;
+	gboolean is_self;
+
+	crawl_context = g_task_get_task_data (visit->task);
+
+	if (crawl_context->stopped)
+		return FALSE;
+
+	uri = gdav_response_get_href (response, 0);
+	if (uri == NULL)
+		return TRUE;
+
+	key = g_strdup (soup_uri_get_path (uri));
+	is_self = gdav_href_equal (key, visit->key);
+
+	/* A Depth:1 PROPFIND repeats the collection itself,
+	 * which the parent collection's listing already
+	 * reported.  Only the starting collection's own
+	 * response gets through here. */
+	if (is_self && !visit->is_root) {
+		g_free (key);
+		return TRUE;
+	}
+
+	if (!crawl_context->func (response, crawl_context->func_data)) {
+		crawl_context->stopped = TRUE;
+		g_free (key);
+		return FALSE;
+	}
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_RESOURCETYPE_PROPERTY, NULL);
+
+	if (!is_self && value != NULL &&
+	    (g_value_get_flags (value) & GDAV_RESOURCE_TYPE_COLLECTION) &&
+	    !g_hash_table_contains (crawl_context->visited, key)) {
+		g_hash_table_add (crawl_context->visited, key);
+		g_queue_push_tail (
+			&crawl_context->pending,
+			soup_uri_copy (uri));
+		key = NULL;
+
+		/* Start on the new collection right away if
+		 * there's room, rather than waiting for this
+		 * listing to finish. */
+		gdav_crawl_dispatch (visit->task);
+	}
+
+	g_free (key);
+
+	return TRUE;
+}
+
+static void
+gdav_crawl_visit_cb (GObject *source_object,
+                     GAsyncResult *result,
+                     gpointer user_data)
+{
+	CrawlVisit *visit = user_data;
+	CrawlContext *crawl_context;
+	GTask *task;
+	GError *local_error = NULL;
+
+	task = g_object_ref (visit->task);
+	crawl_context = g_task_get_task_data (task);
+
+	gdav_propfind_foreach_finish (
+		SOUP_SESSION (source_object), result, NULL, &local_error);
+
+	crawl_context->n_running--;
+
+	if (local_error != NULL) {
+		if (crawl_context->error == NULL)
+			crawl_context->error = local_error;
+		else
+			g_error_free (local_error);
+		crawl_context->stopped = TRUE;
+	}
+
+	crawl_visit_free (visit);
+
+	gdav_crawl_dispatch (task);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_crawl_dispatch (GTask *task)
+{
+	CrawlContext *crawl_context;
+
+	crawl_context = g_task_get_task_data (task);
+
+	while (!crawl_context->stopped &&
+	       crawl_context->n_running < crawl_context->max_concurrent) {
+		CrawlVisit *visit;
+		SoupURI *uri;
+
+		uri = g_queue_pop_head (&crawl_context->pending);
+
+		if (uri == NULL)
+			break;
+
+		visit = g_slice_new0 (CrawlVisit);
+		visit->task = g_object_ref (task);
+		visit->uri = uri;
+		visit->key = g_strdup (soup_uri_get_path (uri));
+		visit->is_root = (crawl_context->n_visits == 0);
+
+		crawl_context->n_running++;
+		crawl_context->n_visits++;
+
+		gdav_propfind_foreach (
+			crawl_context->session, visit->uri,
+			GDAV_PROPFIND_PROP, crawl_context->prop,
+			GDAV_DEPTH_1, gdav_crawl_response_cb, visit,
+			g_task_get_cancellable (task),
+			gdav_crawl_visit_cb, visit);
+	}
+
+	if (crawl_context->n_running > 0 || crawl_context->returned)
+		return;
+
+	if (crawl_context->stopped || g_queue_is_empty (&crawl_context->pending)) {
+		crawl_context->returned = TRUE;
+
+		if (crawl_context->error != NULL) {
+			g_task_return_error (task, crawl_context->error);
+			crawl_context->error = NULL;
+		} else {
+			g_task_return_boolean (task, TRUE);
+		}
+	}
+}
+
+/**
+ * gdav_crawl:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI for the collection to start from
+ * @prop: a #GDavPropertySet, or %NULL
+ * @max_concurrent: maximum number of PROPFIND requests in flight
+ * @func: a #GDavResponseFunc
+ * @func_data: user data to pass to @func
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the crawl is done
+ * @user_data: data to pass to the callback function
+ *
+ * Walks the collection tree under @uri using Depth:1 PROPFIND requests,
+ * for servers that refuse Depth:infinity.  Sub-collections go into a
+ * shared queue as they are discovered and up to @max_concurrent of them
+ * are listed at once.  Every resource found, including @uri itself, is
+ * passed to @func exactly once, in no particular order.  If @func
+ * returns %FALSE the crawl stops early and still completes successfully.
+ *
+ * @prop names the properties to request.  DAV:resourcetype is always
+ * requested as well, since it tells collections apart.
+ **/
+void
+gdav_crawl (SoupSession *session,
+            SoupURI *uri,
+            GDavPropertySet *prop,
+            guint max_concurrent,
+            GDavResponseFunc func,
+            gpointer func_data,
+            GCancellable *cancellable,
+            GAsyncReadyCallback callback,
+            gpointer user_data)
+{
+	GTask *task;
+	CrawlContext *crawl_context;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (func != NULL);
+
+	crawl_context = g_slice_new0 (CrawlContext);
+	crawl_context->session = g_object_ref (session);
+	crawl_context->max_concurrent = MAX (max_concurrent, 1);
+	crawl_context->func = func;
+	crawl_context->func_data = func_data;
+	crawl_context->visited = g_hash_table_new_full (
+		(GHashFunc) gdav_href_hash,
+		(GEqualFunc) gdav_href_equal,
+		(GDestroyNotify) g_free,
+		(GDestroyNotify) NULL);
+	g_queue_init (&crawl_context->pending);
+
+	if (prop != NULL &&
+	    gdav_property_set_has_type (prop, GDAV_TYPE_RESOURCETYPE_PROPERTY)) {
+		crawl_context->prop = g_object_ref (prop);
+	} else {
+		crawl_context->prop = gdav_property_set_new ();
+		gdav_property_set_add_type (
+			crawl_context->prop,
+			GDAV_TYPE_RESOURCETYPE_PROPERTY);
+
+		/* Don't freeze a property set the caller owns. */
+		if (prop != NULL) {
+			GHashTable *parsable_types;
+			GHashTableIter iter;
+			gpointer key;
+
+			parsable_types = g_hash_table_new (NULL, NULL);
+			gdav_parsable_collect_types (
+				GDAV_PARSABLE (prop), parsable_types);
+
+			g_hash_table_iter_init (&iter, parsable_types);
+
+			while (g_hash_table_iter_next (&iter, &key, NULL)) {
+				GType type = GPOINTER_TO_SIZE (key);
+
+				if (g_type_is_a (type, GDAV_TYPE_PROPERTY))
+					gdav_property_set_add_type (
+						crawl_context->prop, type);
+			}
+
+			g_hash_table_destroy (parsable_types);
+		}
+
+		/* Every Depth:1 request sends the same body. */
+		gdav_property_set_freeze (crawl_context->prop);
+	}
+
+	g_hash_table_add (
+		crawl_context->visited,
+		g_strdup (soup_uri_get_path (uri)));
+	g_queue_push_tail (
+		&crawl_context->pending,
+		soup_uri_copy (uri));
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_crawl);
+
+	g_task_set_task_data (
+		task, crawl_context, (GDestroyNotify) crawl_context_free);
+
+	gdav_crawl_dispatch (task);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_crawl_finish (SoupSession *session,
+                   GAsyncResult *result,
+                   GError **error)
+{
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (
+		result, gdav_crawl), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+
+GDavMultiStatus *
+gdav_sync_collection_sync (SoupSession *session,
+                           SoupURI *uri,
+                           const gchar *sync_token,
+                           GDavDepth sync_level,
+                           GDavPropertySet *prop,
+                           GDavResponseFunc func,
+                           gpointer func_data,
+                           SoupMessage **out_message,
+                           GCancellable *cancellable,
+                           GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	GDavMultiStatus *multi_status;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+	g_return_val_if_fail (sync_level != GDAV_DEPTH_0, NULL);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_sync_collection (
+		session, uri, sync_token, sync_level, prop,
+		func, func_data, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	multi_status = gdav_sync_collection_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return multi_status;
+}
+
+static void
+gdav_sync_collection_request_cb (GObject *source_object,
+                                 GAsyncResult *result,
+                                 gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	AsyncContext *async_context;
+	GDavMultiStatus *multi_status;
+	GError *local_error = NULL;
+
+	async_context = g_task_get_task_data (task);
+
+	multi_status = gdav_request_parse_finish (
+		SOUP_REQUEST_HTTP (source_object), result, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((multi_status != NULL) && (local_error == NULL)) ||
+		((multi_status == NULL) && (local_error != NULL)));
+
+	/* RFC 6578 Section 3.2: a 403 for a request with a sync
+	 * token means the token is no longer valid.  Report it as
+	 * an HTTP error so callers can tell it apart and resync. */
+	if (local_error != NULL &&
+	    async_context->message->status_code == SOUP_STATUS_FORBIDDEN) {
+		g_clear_error (&local_error);
+		local_error = g_error_new_literal (
+			SOUP_HTTP_ERROR, SOUP_STATUS_FORBIDDEN,
+			_("The server no longer accepts the sync token"));
+	}
+
+	if (multi_status != NULL)
+		g_task_return_pointer (task, multi_status, g_object_unref);
+
+	if (local_error != NULL)
+		g_task_return_error (task, local_error);
+
+	g_object_unref (task);
+}
+
+/**
+ * gdav_sync_collection:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI for the collection
+ * @sync_token: the sync token from the previous sync, or %NULL
+ * @sync_level: %GDAV_DEPTH_1 or %GDAV_DEPTH_INFINITY
+ * @prop: a #GDavPropertySet naming properties to return, or %NULL
+ * @func: a #GDavResponseFunc, or %NULL
+ * @func_data: user data to pass to @func
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the request is done
+ * @user_data: data to pass to the callback function
+ *
+ * Sends a DAV:sync-collection REPORT (RFC 6578) to find out which
+ * members of @uri have changed or been removed since @sync_token was
+ * issued.  Pass %NULL for @sync_token to get every member.  Removed
+ * members come back as responses with a 404 status and no properties.
+ *
+ * If @func is given, responses are passed to it as they are parsed
+ * instead of being collected in the resulting #GDavMultiStatus.  In
+ * either case, gdav_multi_status_get_sync_token() on the result gives
+ * the token for the next call.
+ *
+ * A server may also limit how many results it sends at once.  It then
+ * adds a 507 Insufficient Storage response for @uri itself, which is
+ * passed to @func or kept in the result like any other, and
+ * gdav_multi_status_get_truncated() on the result returns %TRUE.  The
+ * returned sync token only covers what was sent, so keep calling with
+ * it until the result is no longer truncated.
+ *
+ * A server may stop accepting an old @sync_token at any time, and
+ * answers with 403 Forbidden and a DAV:valid-sync-token precondition.
+ * The operation then fails with a %SOUP_HTTP_ERROR error whose code is
+ * %SOUP_STATUS_FORBIDDEN.  Discard the token and call again with %NULL
+ * to resynchronize the whole collection.
+ **/
+void
+gdav_sync_collection (SoupSession *session,
+                      SoupURI *uri,
+                      const gchar *sync_token,
+                      GDavDepth sync_level,
+                      GDavPropertySet *prop,
+                      GDavResponseFunc func,
+                      gpointer func_data,
+                      GCancellable *cancellable,
+                      GAsyncReadyCallback callback,
+                      gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (sync_level != GDAV_DEPTH_0);
+
+	async_context = g_slice_new0 (AsyncContext);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_sync_collection);
+
+	g_task_set_task_data (
+		task, async_context, (GDestroyNotify) async_context_free);
+
+	request = gdav_request_sync_collection_uri (
+		session, uri, sync_token, sync_level, prop, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request != NULL) {
+		async_context->message =
+			soup_request_http_get_message (request);
+
+		/* With a callback, the GDavMultiStatus we get back
+		 * still holds the DAV:sync-token, just no responses. */
+		gdav_request_parse (
+			request, func, func_data, cancellable,
+			(sync_token != NULL) ?
+			gdav_sync_collection_request_cb :
+			gdav_multi_status_request_cb,
+			g_object_ref (task));
+
+		g_object_unref (request);
+	} else {
+		g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+GDavMultiStatus *
+gdav_sync_collection_finish (SoupSession *session,
+                             GAsyncResult *result,
+                             SoupMessage **out_message,
+                             GError **error)
+{
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), NULL);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (
+		result, gdav_sync_collection), NULL);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = async_context->message;
+		async_context->message = NULL;
+	}
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+gboolean
+gdav_calendar_multiget_sync (SoupSession *session,
+                             SoupURI *uri,
+                             const gchar * const *hrefs,
+                             GDavPropertySet *prop,
+                             guint chunk_size,
+                             guint max_concurrent,
+                             GDavResponseFunc func,
+                             gpointer func_data,
+                             GCancellable *cancellable,
+                             GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (hrefs != NULL, FALSE);
+	g_return_val_if_fail (func != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_calendar_multiget (
+		session, uri, hrefs, prop, chunk_size,
+		max_concurrent, func, func_data, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_calendar_multiget_finish (session, result, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+static void	gdav_calendar_multiget_dispatch	(GTask *task);
+
+static gboolean
+gdav_calendar_multiget_response_cb (GDavResponse *response,
+                                    gpointer user_data)
+{
+	MultigetContext *multiget_context;
+
+	multiget_context = g_task_get_task_data (G_TASK (user_data));
+
+	if (multiget_context->stopped)
+		return FALSE;
+
+	if (!multiget_context->func (response, multiget_context->func_data))
+		multiget_context->stopped = TRUE;
+
+	return !multiget_context->stopped;
+}
+
+static void
+gdav_calendar_multiget_request_cb (GObject *source_object,
+                                   GAsyncResult *result,
+                                   gpointer user_data)
+{
+	GTask *task = G_TASK (user_data);
+	MultigetContext *multiget_context;
+	GDavMultiStatus *multi_status;
+	GError *local_error = NULL;
+
+	multiget_context = g_task_get_task_data (task);
+
+	multi_status = gdav_request_parse_finish (
+		SOUP_REQUEST_HTTP (source_object), result, &local_error);
+
+	if (multi_status != NULL)
+		g_object_unref (multi_status);
+
+	multiget_context->n_running--;
+
+	if (local_error != NULL) {
+		if (multiget_context->error == NULL)
+			multiget_context->error = local_error;
+		else
+			g_error_free (local_error);
+		multiget_context->stopped = TRUE;
+	}
+
+	gdav_calendar_multiget_dispatch (task);
+
+	g_object_unref (task);
+}
+
+static void
+gdav_calendar_multiget_dispatch (GTask *task)
+{
+	MultigetContext *multiget_context;
+
+	multiget_context = g_task_get_task_data (task);
+
+	while (!multiget_context->stopped &&
+	       multiget_context->n_running < multiget_context->max_concurrent &&
+	       multiget_context->next_href < multiget_context->n_hrefs) {
+		SoupRequestHTTP *request;
+		const gchar **chunk;
+		guint ii, length;
+		GError *local_error = NULL;
+
+		length = MIN (
+			multiget_context->chunk_size,
+			multiget_context->n_hrefs -
+			multiget_context->next_href);
+
+		chunk = g_new0 (const gchar *, length + 1);
+		for (ii = 0; ii < length; ii++)
+			chunk[ii] = multiget_context->hrefs[
+				multiget_context->next_href + ii];
+		multiget_context->next_href += length;
+
+		request = gdav_request_calendar_multiget_uri (
+			multiget_context->session,
+			multiget_context->uri,
+			multiget_context->prop,
+			chunk, &local_error);
+
+		g_free (chunk);
+
+		if (request == NULL) {
+			if (multiget_context->error == NULL)
+				multiget_context->error = local_error;
+			else
+				g_error_free (local_error);
+			multiget_context->stopped = TRUE;
+			break;
+		}
+
+		multiget_context->n_running++;
+
+		gdav_request_parse (
+			request,
+			gdav_calendar_multiget_response_cb, task,
+			g_task_get_cancellable (task),
+			gdav_calendar_multiget_request_cb,
+			g_object_ref (task));
+
+		g_object_unref (request);
+	}
+
+	if (multiget_context->n_running > 0 || multiget_context->returned)
+		return;
+
+	if (multiget_context->stopped ||
+	    multiget_context->next_href >= multiget_context->n_hrefs) {
+		multiget_context->returned = TRUE;
+
+		if (multiget_context->error != NULL) {
+			g_task_return_error (task, multiget_context->error);
+			multiget_context->error = NULL;
+		} else {
+			g_task_return_boolean (task, TRUE);
+		}
+	}
+}
+
+/**
+ * gdav_calendar_multiget:
+ * @session: a #SoupSession
+ * @uri: a #SoupURI for the calendar collection
+ * @hrefs: a %NULL-terminated array of calendar object paths
+ * @prop: a #GDavPropertySet naming properties to return, or %NULL
+ * @chunk_size: number of hrefs per request, or 0 for a default
+ * @max_concurrent: maximum number of requests in flight
+ * @func: a #GDavResponseFunc
+ * @func_data: user data to pass to @func
+ * @cancellable: optional #GCancellable object, or %NULL
+ * @callback: a #GAsyncReadyCallback to call when the fetch is done
+ * @user_data: data to pass to the callback function
+ *
+ * Fetches calendar objects in bulk with CalDAV calendar-multiget REPORT
+ * requests (RFC 4791 Section 7.9).  @hrefs is split into requests of at
+ * most @chunk_size entries, and up to @max_concurrent of those are in
+ * flight at once.  Each DAV:response is passed to @func as it is parsed;
+ * use gdav_response_peek_property() with %GDAV_TYPE_CALENDAR_DATA_PROPERTY
+ * to get at the calendar data.  If @func returns %FALSE no more requests
+ * are sent and the operation still completes successfully.
+ *
+ * If @prop is %NULL, DAV:getetag and CALDAV:calendar-data are requested.
+ **/
+void
+gdav_calendar_multiget (SoupSession *session,
+                        SoupURI *uri,
+                        const gchar * const *hrefs,
+                        GDavPropertySet *prop,
+                        guint chunk_size,
+                        guint max_concurrent,
+                        GDavResponseFunc func,
+                        gpointer func_data,
+                        GCancellable *cancellable,
+                        GAsyncReadyCallback callback,
+                        gpointer user_data)
+{
+	GTask *task;
+	MultigetContext *multiget_context;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (hrefs != NULL);
+	g_return_if_fail (prop == NULL || GDAV_IS_PROPERTY_SET (prop));
+	g_return_if_fail (func != NULL);
+
+	multiget_context = g_slice_new0 (MultigetContext);
+	multiget_context->session = g_object_ref (session);
+	multiget_context->uri = soup_uri_copy (uri);
+	multiget_context->hrefs = g_strdupv ((gchar **) hrefs);
+	multiget_context->n_hrefs = g_strv_length (multiget_context->hrefs);
+	multiget_context->chunk_size =
+		(chunk_size > 0) ? chunk_size : MULTIGET_CHUNK_SIZE;
+	multiget_context->max_concurrent = MAX (max_concurrent, 1);
+	multiget_context->func = func;
+	multiget_context->func_data = func_data;
+
+	if (prop != NULL)
+		multiget_context->prop = g_object_ref (prop);
+
+	task = g_task_new (session, cancellable, callback, user_data);
+	g_task_set_source_tag (task, gdav_calendar_multiget);
+
+	g_task_set_task_data (
+		task, multiget_context,
+		(GDestroyNotify) multiget_context_free);
+
+	gdav_calendar_multiget_dispatch (task);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_calendar_multiget_finish (SoupSession *session,
+                               GAsyncResult *result,
+                               GError **error)
+{
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (
+		result, gdav_calendar_multiget), FALSE);
+
+	return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+GDavMultiStatus *
+gdav_proppatch_sync (SoupSession *session,
+                     SoupURI *uri,
+                     GDavPropertyUpdate *update,
+                     SoupMessage **out_message,
+                     GCancellable *cancellable,
+                     GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	GDavMultiStatus *multi_status;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+	g_return_val_if_fail (GDAV_IS_PROPERTY_UPDATE (update), NULL);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_proppatch (
+		session, uri, update, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	multi_status = gdav_proppatch_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return multi_status;
+}
+
+void
+gdav_proppatch (SoupSession *session,
+                SoupURI *uri,
+                GDavPropertyUpdate *update,
+                GCancellable *cancellable,
+                GAsyncReadyCallback callback,
+                gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	AsyncContext *async_context;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (GDAV_IS_PROPERTY_UPDATE (update));
+
+	task = gdav_method_task_new (
+		session, gdav_proppatch, cancellable, callback, user_data);
+
+	async_context = g_task_get_task_data (task);
+
+	request = gdav_request_proppatch_uri (
+		session, uri, update, &local_error);
+
+	/* Sanity check */
+	g_warn_if_fail (
+		((request != NULL) && (local_error == NULL)) ||
+		((request == NULL) && (local_error != NULL)));
+
+	if (request != NULL) {
+		async_context->message =
+			soup_request_http_get_message (request);
+
+		gdav_request_parse (
+			request, NULL, NULL, cancellable,
+			gdav_multi_status_request_cb,
+			g_object_ref (task));
+
+		g_object_unref (request);
+	} else {
+		g_task_return_error (task, local_error);
+	}
+
+	g_object_unref (task);
+}
+
+GDavMultiStatus *
+gdav_proppatch_finish (SoupSession *session,
+                       GAsyncResult *result,
+                       SoupMessage **out_message,
+                       GError **error)
+{
+	AsyncContext *async_context;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), NULL);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_proppatch), NULL);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	/* SoupMessage is set even in case of error for uses
+	 * like calling soup_message_get_https_status() when
+	 * SSL/TLS negotiation fails, though SoupMessage may
+	 * be NULL if the Request-URI was invalid. */
+	if (out_message != NULL) {
+		*out_message = async_context->message;
+		async_context->message = NULL;
+	}
+
+	return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+gboolean
+gdav_mkcol_sync (SoupSession *session,
+                 SoupURI *uri,
+                 SoupMessage **out_message,
+                 GCancellable *cancellable,
+                 GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_mkcol (
+		session, uri, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_mkcol_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+void
+gdav_mkcol (SoupSession *session,
+            SoupURI *uri,
+            GCancellable *cancellable,
+            GAsyncReadyCallback callback,
+            gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+
+	task = gdav_method_task_new (
+		session, gdav_mkcol, cancellable, callback, user_data);
+
+	request = gdav_request_mkcol_uri (session, uri, &local_error);
+
+	gdav_method_send_request (task, request, local_error);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_mkcol_finish (SoupSession *session,
+                   GAsyncResult *result,
+                   SoupMessage **out_message,
+                   GError **error)
+{
+	return gdav_method_finish (
+		session, result, gdav_mkcol, NULL, out_message, error);
+}
+
+gboolean
+gdav_delete_sync (SoupSession *session,
+                  SoupURI *uri,
+                  GDavMultiStatus **out_multi_status,
+                  SoupMessage **out_message,
+                  GCancellable *cancellable,
+                  GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_delete (
+		session, uri, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_delete_finish (
+		session, result, out_multi_status, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+void
+gdav_delete (SoupSession *session,
+             SoupURI *uri,
+             GCancellable *cancellable,
+             GAsyncReadyCallback callback,
+             gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+
+	task = gdav_method_task_new (
+		session, gdav_delete, cancellable, callback, user_data);
+
+	request = gdav_request_delete_uri (session, uri, &local_error);
+
+	gdav_method_send_request (task, request, local_error);
+
+	g_object_unref (task);
+}
+
+/**
+ * gdav_delete_finish:
+ * @session: a #SoupSession
+ * @result: a #GAsyncResult
+ * @out_multi_status: return location for a #GDavMultiStatus, or %NULL
+ * @out_message: return location for a #SoupMessage, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes the operation started with gdav_delete().
+ *
+ * If the server could not delete some members of a collection, the
+ * operation fails and @out_multi_status is set to the multistatus
+ * response describing which.  The same applies to gdav_copy_finish()
+ * and gdav_move_finish().
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ **/
+gboolean
+gdav_delete_finish (SoupSession *session,
+                    GAsyncResult *result,
+                    GDavMultiStatus **out_multi_status,
+                    SoupMessage **out_message,
+                    GError **error)
+{
+	return gdav_method_finish (
+		session, result, gdav_delete,
+		out_multi_status, out_message, error);
+}
+
+gboolean
+gdav_copy_sync (SoupSession *session,
+                SoupURI *uri,
+                const gchar *destination,
+                GDavCopyFlags flags,
+                GDavMultiStatus **out_multi_status,
+                SoupMessage **out_message,
+                GCancellable *cancellable,
+                GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (destination != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_copy (
+		session, uri, destination, flags, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_copy_finish (
+		session, result, out_multi_status, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+void
+gdav_copy (SoupSession *session,
+           SoupURI *uri,
+           const gchar *destination,
+           GDavCopyFlags flags,
+           GCancellable *cancellable,
+           GAsyncReadyCallback callback,
+           gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (destination != NULL);
+
+	task = gdav_method_task_new (
+		session, gdav_copy, cancellable, callback, user_data);
+
+	request = gdav_request_copy_uri (
+		session, uri, destination, flags, &local_error);
+
+	gdav_method_send_request (task, request, local_error);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_copy_finish (SoupSession *session,
+                  GAsyncResult *result,
+                  GDavMultiStatus **out_multi_status,
+                  SoupMessage **out_message,
+                  GError **error)
+{
+	return gdav_method_finish (
+		session, result, gdav_copy,
+		out_multi_status, out_message, error);
+}
+
+gboolean
+gdav_move_sync (SoupSession *session,
+                SoupURI *uri,
+                const gchar *destination,
+                GDavMoveFlags flags,
+                GDavMultiStatus **out_multi_status,
+                SoupMessage **out_message,
+                GCancellable *cancellable,
+                GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (destination != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_move (
+		session, uri, destination, flags, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_move_finish (
+		session, result, out_multi_status, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+void
+gdav_move (SoupSession *session,
+           SoupURI *uri,
+           const gchar *destination,
+           GDavMoveFlags flags,
+           GCancellable *cancellable,
+           GAsyncReadyCallback callback,
+           gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (destination != NULL);
+
+	task = gdav_method_task_new (
+		session, gdav_move, cancellable, callback, user_data);
+
+	request = gdav_request_move_uri (
+		session, uri, destination, flags, &local_error);
+
+	gdav_method_send_request (task, request, local_error);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_move_finish (SoupSession *session,
+                  GAsyncResult *result,
+                  GDavMultiStatus **out_multi_status,
+                  SoupMessage **out_message,
+                  GError **error)
+{
+	return gdav_method_finish (
+		session, result, gdav_move,
+		out_multi_status, out_message, error);
+}
+
+gboolean
+gdav_lock_sync (SoupSession *session,
+                SoupURI *uri,
+                GDavLockScope lock_scope,
+                GDavLockType lock_type,
+                GDavLockFlags flags,
+                const gchar *owner,
+                gint timeout,
+                gchar **out_lock_token,
+                SoupMessage **out_message,
+                GCancellable *cancellable,
+                GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_lock (
+		session, uri, lock_scope, lock_type,
+		flags, owner, timeout, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_lock_finish (
+		session, result, out_lock_token, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+void
+gdav_lock (SoupSession *session,
+           SoupURI *uri,
+           GDavLockScope lock_scope,
+           GDavLockType lock_type,
+           GDavLockFlags flags,
+           const gchar *owner,
+           gint timeout,
+           GCancellable *cancellable,
+           GAsyncReadyCallback callback,
+           gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+
+	task = gdav_method_task_new (
+		session, gdav_lock, cancellable, callback, user_data);
+
+	request = gdav_request_lock_uri (
+		session, uri, lock_scope, lock_type,
+		flags, owner, timeout, &local_error);
+
+	gdav_method_send_request (task, request, local_error);
+
+	g_object_unref (task);
+}
+
+/**
+ * gdav_lock_finish:
+ * @session: a #SoupSession
+ * @result: a #GAsyncResult
+ * @out_lock_token: return location for the lock token, or %NULL
+ * @out_message: return location for a #SoupMessage, or %NULL
+ * @error: return location for a #GError, or %NULL
+ *
+ * Finishes the operation started with gdav_lock().  The lock token
+ * is taken from the Lock-Token response header, without the angle
+ * brackets, and should be freed with g_free().
+ *
+ * Returns: %TRUE on success, %FALSE on failure
+ **/
+gboolean
+gdav_lock_finish (SoupSession *session,
+                  GAsyncResult *result,
+                  gchar **out_lock_token,
+                  SoupMessage **out_message,
+                  GError **error)
+{
+	AsyncContext *async_context;
+	gchar *lock_token = NULL;
+	gboolean success;
+
+	g_return_val_if_fail (
+		g_task_is_valid (result, session), FALSE);
+	g_return_val_if_fail (
+		g_async_result_is_tagged (result, gdav_lock), FALSE);
+
+	async_context = g_task_get_task_data (G_TASK (result));
+
+	if (!g_task_had_error (G_TASK (result))) {
+		const gchar *header;
+
+		header = soup_message_headers_get_one (
+			async_context->message->response_headers,
+			"Lock-Token");
+
+		/* Lock-Token is a Coded-URL: "<" absolute-URI ">" */
+		if (header != NULL) {
+			header += strspn (header, " \t<");
+			lock_token = g_strndup (
+				header, strcspn (header, ">"));
+		}
+	}
+
+	success = gdav_method_finish (
+		session, result, gdav_lock, NULL, out_message, error);
+
+	if (success && lock_token == NULL) {
+		g_set_error (
+			error, GDAV_PARSABLE_ERROR,
+			GDAV_PARSABLE_ERROR_INTERNAL,
+			_("Missing Lock-Token in response"));
+		success = FALSE;
+	}
+
+	if (success && out_lock_token != NULL)
+		*out_lock_token = lock_token;
+	else
+		g_free (lock_token);
+
+	return success;
+}
+
+gboolean
+gdav_unlock_sync (SoupSession *session,
+                  SoupURI *uri,
+                  const gchar *lock_token,
+                  SoupMessage **out_message,
+                  GCancellable *cancellable,
+                  GError **error)
+{
+	GDavAsyncClosure *closure;
+	GAsyncResult *result;
+	gboolean success;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), FALSE);
+	g_return_val_if_fail (uri != NULL, FALSE);
+	g_return_val_if_fail (lock_token != NULL, FALSE);
+
+	closure = gdav_async_closure_new ();
+
+	gdav_unlock (
+		session, uri, lock_token, cancellable,
+		gdav_async_closure_callback, closure);
+
+	result = gdav_async_closure_wait (closure);
+
+	success = gdav_unlock_finish (
+		session, result, out_message, error);
+
+	gdav_async_closure_free (closure);
+
+	return success;
+}
+
+void
+gdav_unlock (SoupSession *session,
+             SoupURI *uri,
+             const gchar *lock_token,
+             GCancellable *cancellable,
+             GAsyncReadyCallback callback,
+             gpointer user_data)
+{
+	GTask *task;
+	SoupRequestHTTP *request;
+	GError *local_error = NULL;
+
+	g_return_if_fail (SOUP_IS_SESSION (session));
+	g_return_if_fail (uri != NULL);
+	g_return_if_fail (lock_token != NULL);
+
+	task = gdav_method_task_new (
+		session, gdav_unlock, cancellable, callback, user_data);
+
+	request = gdav_request_unlock_uri (
+		session, uri, lock_token, &local_error);
+
+	gdav_method_send_request (task, request, local_error);
+
+	g_object_unref (task);
+}
+
+gboolean
+gdav_unlock_finish (SoupSession *session,
+                    GAsyncResult *result,
+                    SoupMessage **out_message,
+                    GError **error)
+{
+	return gdav_method_finish (
+		session, result, gdav_unlock, NULL, out_message, error);
+}
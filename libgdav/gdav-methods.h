@@ -20,6 +20,7 @@
 #ifndef __GDAV_METHODS_H__
 #define __GDAV_METHODS_H__
 
+#include <libgdav/gdav-listing.h>
 #include <libgdav/gdav-multi-status.h>
 #include <libgdav/gdav-requests.h>
 
@@ -44,6 +45,131 @@ gboolean	gdav_options_finish		(SoupSession *session,
 						 SoupMessage **out_message,
 						 GError **error);
 
+gboolean	gdav_get_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 GOutputStream *output_stream,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_get			(SoupSession *session,
+						 SoupURI *uri,
+						 GOutputStream *output_stream,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_get_finish			(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_get_parallel_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 guint max_ranges,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_get_parallel		(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 guint max_ranges,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_get_parallel_finish	(SoupSession *session,
+						 GAsyncResult *result,
+						 GError **error);
+gboolean	gdav_get_resume_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 GFile *checkpoint,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_get_resume			(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 GFile *checkpoint,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_get_resume_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+gboolean	gdav_put_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 GInputStream *input_stream,
+						 goffset content_length,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags,
+						 gchar **out_etag,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_put			(SoupSession *session,
+						 SoupURI *uri,
+						 GInputStream *input_stream,
+						 goffset content_length,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_put_finish			(SoupSession *session,
+						 GAsyncResult *result,
+						 gchar **out_etag,
+						 SoupMessage **out_message,
+						 GError **error);
+gboolean	gdav_put_file_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags,
+						 gchar **out_etag,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_put_file			(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_put_file_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 gchar **out_etag,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_put_resume_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 GFile *checkpoint,
+						 const gchar *content_type,
+						 gchar **out_etag,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_put_resume			(SoupSession *session,
+						 SoupURI *uri,
+						 GFile *file,
+						 GFile *checkpoint,
+						 const gchar *content_type,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_put_resume_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 gchar **out_etag,
+						 SoupMessage **out_message,
+						 GError **error);
+
 GDavMultiStatus *
 		gdav_propfind_sync		(SoupSession *session,
 						 SoupURI *uri,
@@ -67,6 +193,258 @@ GDavMultiStatus *
 						 SoupMessage **out_message,
 						 GError **error);
 
+gboolean	gdav_propfind_foreach_sync	(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropFindType type,
+						 GDavPropertySet *prop,
+						 GDavDepth depth,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_propfind_foreach		(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropFindType type,
+						 GDavPropertySet *prop,
+						 GDavDepth depth,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_propfind_foreach_finish	(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
+GDavListing *	gdav_propfind_listing_sync	(SoupSession *session,
+						 SoupURI *uri,
+						 GDavDepth depth,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_propfind_listing		(SoupSession *session,
+						 SoupURI *uri,
+						 GDavDepth depth,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+GDavListing *	gdav_propfind_listing_finish	(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_crawl_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropertySet *prop,
+						 guint max_concurrent,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_crawl			(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropertySet *prop,
+						 guint max_concurrent,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_crawl_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 GError **error);
+
+GDavMultiStatus *
+		gdav_sync_collection_sync	(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *sync_token,
+						 GDavDepth sync_level,
+						 GDavPropertySet *prop,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_sync_collection		(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *sync_token,
+						 GDavDepth sync_level,
+						 GDavPropertySet *prop,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+GDavMultiStatus *
+		gdav_sync_collection_finish	(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_calendar_multiget_sync	(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar * const *hrefs,
+						 GDavPropertySet *prop,
+						 guint chunk_size,
+						 guint max_concurrent,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_calendar_multiget		(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar * const *hrefs,
+						 GDavPropertySet *prop,
+						 guint chunk_size,
+						 guint max_concurrent,
+						 GDavResponseFunc func,
+						 gpointer func_data,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_calendar_multiget_finish	(SoupSession *session,
+						 GAsyncResult *result,
+						 GError **error);
+
+GDavMultiStatus *
+		gdav_proppatch_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropertyUpdate *update,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_proppatch			(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropertyUpdate *update,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+GDavMultiStatus *
+		gdav_proppatch_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_mkcol_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_mkcol			(SoupSession *session,
+						 SoupURI *uri,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_mkcol_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_delete_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 GDavMultiStatus **out_multi_status,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_delete			(SoupSession *session,
+						 SoupURI *uri,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_delete_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 GDavMultiStatus **out_multi_status,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_copy_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *destination,
+						 GDavCopyFlags flags,
+						 GDavMultiStatus **out_multi_status,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_copy			(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *destination,
+						 GDavCopyFlags flags,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_copy_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 GDavMultiStatus **out_multi_status,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_move_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *destination,
+						 GDavMoveFlags flags,
+						 GDavMultiStatus **out_multi_status,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_move			(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *destination,
+						 GDavMoveFlags flags,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_move_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 GDavMultiStatus **out_multi_status,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_lock_sync			(SoupSession *session,
+						 SoupURI *uri,
+						 GDavLockScope lock_scope,
+						 GDavLockType lock_type,
+						 GDavLockFlags flags,
+						 const gchar *owner,
+						 gint timeout,
+						 gchar **out_lock_token,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_lock			(SoupSession *session,
+						 SoupURI *uri,
+						 GDavLockScope lock_scope,
+						 GDavLockType lock_type,
+						 GDavLockFlags flags,
+						 const gchar *owner,
+						 gint timeout,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_lock_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 gchar **out_lock_token,
+						 SoupMessage **out_message,
+						 GError **error);
+
+gboolean	gdav_unlock_sync		(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *lock_token,
+						 SoupMessage **out_message,
+						 GCancellable *cancellable,
+						 GError **error);
+void		gdav_unlock			(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *lock_token,
+						 GCancellable *cancellable,
+						 GAsyncReadyCallback callback,
+						 gpointer user_data);
+gboolean	gdav_unlock_finish		(SoupSession *session,
+						 GAsyncResult *result,
+						 SoupMessage **out_message,
+						 GError **error);
+
 G_END_DECLS
 
 #endif /* __GDAV_METHODS_H__ */
@@ -19,8 +19,21 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gdav-multi-status.h"
 
+#include <glib/gi18n-lib.h>
+#include <libxml/SAX2.h>
+
+#include "gdav-arena.h"
+#include "gdav-getcontentlength-property.h"
+#include "gdav-getetag-property.h"
+#include "gdav-getlastmodified-property.h"
+#include "gdav-resourcetype-property.h"
+#include "gdav-utils-private.h"
+#include "gdav-xml-tokens.h"
+
 #define GDAV_MULTI_STATUS_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), GDAV_TYPE_MULTI_STATUS, GDavMultiStatusPrivate))
@@ -28,6 +41,31 @@
 struct _GDavMultiStatusPrivate {
 	GPtrArray *responses;
 	gchar *description;
+	gchar *sync_token;
+	gboolean truncated;
+
+	/* Maps href paths to responses, ignoring a trailing
+	 * slash.  Built on demand by gdav_multi_status_get_
+	 * response_by_href() and covers the first n_indexed
+	 * responses. */
+	GHashTable *href_index;
+	guint n_indexed;
+
+	/* Holds text for the responses built by a
+	 * GDavMultiStatusParser, freed all at once. */
+	GDavArena *arena;
+};
+
+struct _GDavMultiStatusParser {
+	xmlParserCtxt *ctxt;
+	GDavXmlTokenizer *tokenizer;
+	SoupURI *base_uri;
+	GDavMultiStatus *multi_status;
+	GDavArena *arena;
+	GDavResponseFunc func;
+	gpointer user_data;
+	gboolean stopped;
+	GError *error;
 };
 
 enum {
@@ -64,6 +102,12 @@ gdav_multi_status_dispose (GObject *object)
 
 	g_ptr_array_set_size (priv->responses, 0);
 
+	if (priv->href_index != NULL) {
+		g_hash_table_destroy (priv->href_index);
+		priv->href_index = NULL;
+		priv->n_indexed = 0;
+	}
+
 	/* Chain up to parent's dispose() method. */
 	G_OBJECT_CLASS (gdav_multi_status_parent_class)->dispose (object);
 }
@@ -77,6 +121,10 @@ gdav_multi_status_finalize (GObject *object)
 
 	g_ptr_array_free (priv->responses, TRUE);
 	g_free (priv->description);
+	g_free (priv->sync_token);
+
+	if (priv->arena != NULL)
+		gdav_arena_unref (priv->arena);
 
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (gdav_multi_status_parent_class)->finalize (object);
@@ -84,6 +132,7 @@ gdav_multi_status_finalize (GObject *object)
 
 static gboolean
 gdav_multi_status_deserialize_dav (GDavParsable *parsable,
+                                   GDavXmlToken token,
                                    SoupURI *base_uri,
                                    xmlDoc *doc,
                                    xmlNode *node,
@@ -95,7 +144,7 @@ gdav_multi_status_deserialize_dav (GDavParsable *parsable,
 
 	/* Handle nodes in the GDAV_XMLNS_DAV namespace. */
 
-	if (xmlStrcmp (node->name, BAD_CAST "response") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_RESPONSE) {
 		GDavParsable *item;
 
 		item = gdav_parsable_new_from_xml_node (
@@ -108,7 +157,7 @@ gdav_multi_status_deserialize_dav (GDavParsable *parsable,
 		return TRUE;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "responsedescription") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_RESPONSEDESCRIPTION) {
 		xmlChar *text;
 
 		text = xmlNodeListGetString (doc, node->children, TRUE);
@@ -119,6 +168,21 @@ gdav_multi_status_deserialize_dav (GDavParsable *parsable,
 		return TRUE;
 	}
 
+	/* RFC 6578 Section 6.2 */
+	if (token == GDAV_XML_TOKEN_DAV_SYNC_TOKEN) {
+		xmlChar *text;
+
+		text = xmlNodeListGetString (doc, node->children, TRUE);
+
+		if (text != NULL)
+			g_strstrip ((gchar *) text);
+
+		g_free (priv->sync_token);
+		priv->sync_token = (gchar *) text;
+
+		return TRUE;
+	}
+
 	/* Chain up to parent's deserialize() method. */
 	return GDAV_PARSABLE_CLASS (gdav_multi_status_parent_class)->
 		deserialize (parsable, base_uri, doc, node, error);
@@ -131,9 +195,13 @@ gdav_multi_status_deserialize (GDavParsable *parsable,
                                xmlNode *node,
                                GError **error)
 {
-	if (gdav_is_xmlns (node, GDAV_XMLNS_DAV)) {
+	GDavXmlToken token;
+
+	token = gdav_xml_node_get_token (node);
+
+	if (token != GDAV_XML_TOKEN_OTHER) {
 		return gdav_multi_status_deserialize_dav (
-			parsable, base_uri, doc, node, error);
+			parsable, token, base_uri, doc, node, error);
 	}
 
 	/* Chain up to parent's deserialize() method. */
@@ -201,21 +269,100 @@ gdav_multi_status_get_response (GDavMultiStatus *multi_status,
 	return response;
 }
 
+static void
+gdav_multi_status_update_href_index (GDavMultiStatus *multi_status)
+{
+	GDavMultiStatusPrivate *priv;
+
+	priv = multi_status->priv;
+
+	if (priv->href_index == NULL)
+		priv->href_index = g_hash_table_new (
+			gdav_href_hash, gdav_href_equal);
+
+	/* Responses are only ever appended, so just
+	 * index the ones added since the last lookup. */
+	for (; priv->n_indexed < priv->responses->len; priv->n_indexed++) {
+		GDavResponse *response;
+		guint ii, n_hrefs;
+
+		response = priv->responses->pdata[priv->n_indexed];
+		n_hrefs = gdav_response_get_n_hrefs (response);
+
+		for (ii = 0; ii < n_hrefs; ii++) {
+			SoupURI *href;
+			const gchar *path;
+
+			href = gdav_response_get_href (response, ii);
+			path = soup_uri_get_path (href);
+
+			/* Keep the first response for a path so
+			 * lookups agree with a front-to-back scan. */
+			if (!g_hash_table_contains (priv->href_index, path))
+				g_hash_table_insert (
+					priv->href_index,
+					(gpointer) path, response);
+		}
+	}
+}
+
+/* Like gdav_response_has_href(), but ignores a trailing slash. */
+static gboolean
+gdav_multi_status_response_has_href (GDavResponse *response,
+                                     SoupURI *uri)
+{
+	guint ii, n_hrefs;
+
+	n_hrefs = gdav_response_get_n_hrefs (response);
+
+	for (ii = 0; ii < n_hrefs; ii++) {
+		SoupURI *href;
+
+		href = gdav_response_get_href (response, ii);
+
+		if (soup_uri_host_equal (uri, href) &&
+		    gdav_href_equal (
+			soup_uri_get_path (uri),
+			soup_uri_get_path (href)) &&
+		    g_strcmp0 (
+			soup_uri_get_query (uri),
+			soup_uri_get_query (href)) == 0)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
 GDavResponse *
 gdav_multi_status_get_response_by_href (GDavMultiStatus *multi_status,
                                         SoupURI *uri)
 {
+	GDavResponse *response;
 	guint ii, n_responses;
 
 	g_return_val_if_fail (GDAV_IS_MULTI_STATUS (multi_status), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	gdav_multi_status_update_href_index (multi_status);
+
+	response = g_hash_table_lookup (
+		multi_status->priv->href_index,
+		soup_uri_get_path (uri));
 
+	/* Every href is in the index, so a miss is final. */
+	if (response == NULL)
+		return NULL;
+
+	if (gdav_multi_status_response_has_href (response, uri))
+		return response;
+
+	/* The index is keyed on path alone.  If the paths match but
+	 * the rest of the URI doesn't, fall back to a full scan. */
 	n_responses = gdav_multi_status_get_n_responses (multi_status);
 
 	for (ii = 0; ii < n_responses; ii++) {
-		GDavResponse *response;
-
 		response = gdav_multi_status_get_response (multi_status, ii);
-		if (gdav_response_has_href (response, uri))
+		if (gdav_multi_status_response_has_href (response, uri))
 			return response;
 	}
 
@@ -238,3 +385,565 @@ gdav_multi_status_get_description (GDavMultiStatus *multi_status)
 	return multi_status->priv->description;
 }
 
+/**
+ * gdav_multi_status_get_sync_token:
+ * @multi_status: a #GDavMultiStatus
+ *
+ * Returns the DAV:sync-token from a DAV:sync-collection report
+ * response, to be passed to the next gdav_sync_collection() call.
+ *
+ * Returns: the sync token, or %NULL
+ **/
+const gchar *
+gdav_multi_status_get_sync_token (GDavMultiStatus *multi_status)
+{
+	g_return_val_if_fail (GDAV_IS_MULTI_STATUS (multi_status), NULL);
+
+	return multi_status->priv->sync_token;
+}
+
+/**
+ * gdav_multi_status_get_truncated:
+ * @multi_status: a #GDavMultiStatus
+ *
+ * Returns whether the server left responses out of @multi_status.
+ * Per RFC 6578 Section 3.6, a server limiting the results of a
+ * DAV:sync-collection report includes a 507 Insufficient Storage
+ * response for the request-URI itself.  The sync token then only
+ * covers the responses that were sent, so call gdav_sync_collection()
+ * again with it to get the rest.
+ *
+ * Returns: %TRUE if the results are incomplete
+ **/
+gboolean
+gdav_multi_status_get_truncated (GDavMultiStatus *multi_status)
+{
+	g_return_val_if_fail (GDAV_IS_MULTI_STATUS (multi_status), FALSE);
+
+	return multi_status->priv->truncated;
+}
+
+static void
+gdav_multi_status_get_state (GDavResponse *response,
+                             GDavResourceState *state)
+{
+	const GValue *value;
+
+	memset (state, 0, sizeof (GDavResourceState));
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_RESOURCETYPE_PROPERTY, NULL);
+	if (value != NULL)
+		state->resource_type = g_value_get_flags (value);
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETETAG_PROPERTY, NULL);
+	if (value != NULL)
+		state->etag = g_value_get_string (value);
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETCONTENTLENGTH_PROPERTY, NULL);
+	if (value != NULL)
+		state->content_length = g_value_get_uint64 (value);
+
+	value = gdav_response_peek_property (
+		response, GDAV_TYPE_GETLASTMODIFIED_PROPERTY, NULL);
+	if (value != NULL && g_value_get_boxed (value) != NULL)
+		state->last_modified = g_date_time_to_unix (
+			g_value_get_boxed (value));
+}
+
+static gboolean
+gdav_multi_status_response_changed (GDavResponse *old_response,
+                                    GDavResponse *new_response)
+{
+	GDavResourceState old_state;
+	GDavResourceState new_state;
+
+	gdav_multi_status_get_state (old_response, &old_state);
+	gdav_multi_status_get_state (new_response, &new_state);
+
+	return gdav_resource_state_changed (&old_state, &new_state);
+}
+
+/**
+ * gdav_multi_status_diff:
+ * @old_status: an earlier #GDavMultiStatus
+ * @new_status: a later #GDavMultiStatus for the same collection
+ * @out_added: return location for a #GPtrArray, or %NULL
+ * @out_removed: return location for a #GPtrArray, or %NULL
+ * @out_changed: return location for a #GPtrArray, or %NULL
+ *
+ * Compares two listings of the same collection, matching responses by
+ * the path of their first DAV:href.  A trailing slash is ignored when
+ * matching.  A response counts as changed if its DAV:resourcetype
+ * differs, or by DAV:getetag if either response has one, or else by
+ * DAV:getcontentlength and DAV:getlastmodified.  #GDavSnapshot uses
+ * the same rule.  If an href occurs more than once in a listing, only
+ * its first response is used.
+ *
+ * Each array holds #GDavResponse references, in document order.
+ * Added and changed responses come from @new_status.  Removed
+ * responses come from @old_status.  Free the arrays with
+ * g_ptr_array_unref().
+ *
+ * This runs in time linear in the number of responses.
+ *
+ * Returns: %TRUE if there were any differences
+ **/
+gboolean
+gdav_multi_status_diff (GDavMultiStatus *old_status,
+                        GDavMultiStatus *new_status,
+                        GPtrArray **out_added,
+                        GPtrArray **out_removed,
+                        GPtrArray **out_changed)
+{
+	GHashTable *old_hrefs;
+	GHashTable *new_hrefs;
+	GPtrArray *added;
+	GPtrArray *removed;
+	GPtrArray *changed;
+	gboolean any_changes;
+	guint ii, n_responses;
+
+	g_return_val_if_fail (GDAV_IS_MULTI_STATUS (old_status), FALSE);
+	g_return_val_if_fail (GDAV_IS_MULTI_STATUS (new_status), FALSE);
+
+	added = g_ptr_array_new_with_free_func (g_object_unref);
+	removed = g_ptr_array_new_with_free_func (g_object_unref);
+	changed = g_ptr_array_new_with_free_func (g_object_unref);
+
+	/* Keys are owned by the responses, so nothing is copied. */
+	old_hrefs = g_hash_table_new (gdav_href_hash, gdav_href_equal);
+	new_hrefs = g_hash_table_new (gdav_href_hash, gdav_href_equal);
+
+	n_responses = gdav_multi_status_get_n_responses (old_status);
+
+	for (ii = 0; ii < n_responses; ii++) {
+		GDavResponse *response;
+		SoupURI *href;
+
+		response = gdav_multi_status_get_response (old_status, ii);
+		href = gdav_response_get_href (response, 0);
+
+		if (href == NULL)
+			continue;
+
+		if (!g_hash_table_contains (old_hrefs, soup_uri_get_path (href)))
+			g_hash_table_insert (
+				old_hrefs,
+				(gpointer) soup_uri_get_path (href),
+				response);
+	}
+
+	n_responses = gdav_multi_status_get_n_responses (new_status);
+
+	for (ii = 0; ii < n_responses; ii++) {
+		GDavResponse *response;
+		GDavResponse *old_response;
+		SoupURI *href;
+		const gchar *path;
+
+		response = gdav_multi_status_get_response (new_status, ii);
+		href = gdav_response_get_href (response, 0);
+
+		if (href == NULL)
+			continue;
+
+		path = soup_uri_get_path (href);
+
+		if (g_hash_table_contains (new_hrefs, path))
+			continue;
+
+		g_hash_table_insert (new_hrefs, (gpointer) path, response);
+
+		old_response = g_hash_table_lookup (old_hrefs, path);
+
+		if (old_response == NULL) {
+			g_ptr_array_add (added, g_object_ref (response));
+
+		} else if (gdav_multi_status_response_changed (
+			old_response, response)) {
+			g_ptr_array_add (changed, g_object_ref (response));
+		}
+	}
+
+	/* Walk the old listing again rather than the hash
+	 * table so removed responses stay in document order. */
+	n_responses = gdav_multi_status_get_n_responses (old_status);
+
+	for (ii = 0; ii < n_responses; ii++) {
+		GDavResponse *response;
+		SoupURI *href;
+		const gchar *path;
+
+		response = gdav_multi_status_get_response (old_status, ii);
+		href = gdav_response_get_href (response, 0);
+
+		if (href == NULL)
+			continue;
+
+		path = soup_uri_get_path (href);
+
+		/* Skip repeated hrefs. */
+		if (g_hash_table_lookup (old_hrefs, path) != response)
+			continue;
+
+		if (!g_hash_table_contains (new_hrefs, path))
+			g_ptr_array_add (removed, g_object_ref (response));
+	}
+
+	g_hash_table_destroy (old_hrefs);
+	g_hash_table_destroy (new_hrefs);
+
+	any_changes =
+		(added->len > 0) ||
+		(removed->len > 0) ||
+		(changed->len > 0);
+
+	if (out_added != NULL)
+		*out_added = g_ptr_array_ref (added);
+
+	if (out_removed != NULL)
+		*out_removed = g_ptr_array_ref (removed);
+
+	if (out_changed != NULL)
+		*out_changed = g_ptr_array_ref (changed);
+
+	g_ptr_array_unref (added);
+	g_ptr_array_unref (removed);
+	g_ptr_array_unref (changed);
+
+	return any_changes;
+}
+
+static void
+gdav_multi_status_parser_start_element (void *ctx,
+                                        const xmlChar *localname,
+                                        const xmlChar *prefix,
+                                        const xmlChar *URI,
+                                        gint nb_namespaces,
+                                        const xmlChar **namespaces,
+                                        gint nb_attributes,
+                                        gint nb_defaulted,
+                                        const xmlChar **attributes)
+{
+	xmlParserCtxt *ctxt = ctx;
+	GDavMultiStatusParser *parser = ctxt->_private;
+	xmlNode *node;
+
+	xmlSAX2StartElementNs (
+		ctx, localname, prefix, URI,
+		nb_namespaces, namespaces,
+		nb_attributes, nb_defaulted, attributes);
+
+	node = ctxt->node;
+
+	if (node == NULL)
+		return;
+
+	gdav_xml_node_set_token (
+		node, gdav_xml_tokenizer_lookup (
+		parser->tokenizer, localname, URI));
+
+	if (node->parent != (xmlNode *) ctxt->myDoc)
+		return;
+
+	/* Reject anything but a <multistatus> root element up front
+	 * rather than buffering a document we're going to discard. */
+	if (!gdav_parsable_is_a (node, GDAV_TYPE_MULTI_STATUS)) {
+		g_set_error (
+			&parser->error, GDAV_PARSABLE_ERROR,
+			GDAV_PARSABLE_ERROR_UNEXPECTED_ELEMENT,
+			_("Unexpected XML element <%s>"),
+			node->name);
+		xmlStopParser (ctxt);
+	}
+}
+
+/* Notes a 507 response for the request-URI itself,
+ * which means the server truncated the results. */
+static void
+gdav_multi_status_parser_check_truncated (GDavMultiStatusParser *parser,
+                                          GDavResponse *response)
+{
+	SoupURI *base_uri = parser->base_uri;
+	guint ii, n_hrefs;
+
+	if (gdav_response_get_status (response, NULL) !=
+	    SOUP_STATUS_INSUFFICIENT_STORAGE)
+		return;
+
+	n_hrefs = gdav_response_get_n_hrefs (response);
+
+	for (ii = 0; ii < n_hrefs; ii++) {
+		SoupURI *href;
+
+		href = gdav_response_get_href (response, ii);
+
+		if (soup_uri_host_equal (base_uri, href) &&
+		    gdav_href_equal (
+			soup_uri_get_path (base_uri),
+			soup_uri_get_path (href)))
+			parser->multi_status->priv->truncated = TRUE;
+	}
+}
+
+static void
+gdav_multi_status_parser_end_element (void *ctx,
+                                      const xmlChar *localname,
+                                      const xmlChar *prefix,
+                                      const xmlChar *URI)
+{
+	xmlParserCtxt *ctxt = ctx;
+	GDavMultiStatusParser *parser = ctxt->_private;
+	xmlNode *node;
+	xmlNode *root;
+	gboolean success;
+
+	/* This is the element being closed. */
+	node = ctxt->node;
+
+	xmlSAX2EndElementNs (ctx, localname, prefix, URI);
+
+	/* We only act on the children of the root element.
+	 * Anything deeper belongs to the subtree of one of them. */
+	if (node == NULL || node->parent == NULL)
+		return;
+
+	root = node->parent;
+
+	if (root->parent != (xmlNode *) ctxt->myDoc)
+		return;
+
+	if (parser->func != NULL &&
+	    gdav_xml_node_get_token (node) == GDAV_XML_TOKEN_DAV_RESPONSE) {
+		GDavParsable *item;
+
+		item = gdav_parsable_new_from_xml_node (
+			GDAV_TYPE_RESPONSE, parser->base_uri,
+			ctxt->myDoc, node, &parser->error);
+		success = (item != NULL);
+
+		if (item != NULL) {
+			gdav_multi_status_parser_check_truncated (
+				parser, GDAV_RESPONSE (item));
+			if (!parser->func (GDAV_RESPONSE (item), parser->user_data))
+				parser->stopped = TRUE;
+			g_object_unref (item);
+		}
+	} else {
+		GPtrArray *responses;
+		guint n_responses;
+
+		responses = parser->multi_status->priv->responses;
+		n_responses = responses->len;
+
+		success = gdav_parsable_deserialize (
+			GDAV_PARSABLE (parser->multi_status),
+			parser->base_uri, ctxt->myDoc,
+			node, &parser->error);
+
+		if (success && responses->len > n_responses)
+			gdav_multi_status_parser_check_truncated (
+				parser, responses->pdata[n_responses]);
+	}
+
+	/* The subtree is fully consumed, so discard it along with
+	 * any whitespace or comments collected before it.  This is
+	 * what keeps memory usage bounded by a single <response>. */
+	while (root->children != NULL) {
+		xmlNode *child = root->children;
+
+		xmlUnlinkNode (child);
+		xmlFreeNode (child);
+	}
+
+	if (!success || parser->stopped)
+		xmlStopParser (ctxt);
+}
+
+GDavMultiStatusParser *
+gdav_multi_status_parser_new (SoupURI *base_uri,
+                              GDavResponseFunc func,
+                              gpointer user_data)
+{
+	GDavMultiStatusParser *parser;
+	xmlSAXHandler sax;
+
+	g_return_val_if_fail (SOUP_URI_VALID_FOR_HTTP (base_uri), NULL);
+
+	/* Start from the default SAX2 tree builder and intercept
+	 * element boundaries.  Each top-level subtree is turned into
+	 * GDavParsable objects and freed as soon as it's complete. */
+	memset (&sax, 0, sizeof (xmlSAXHandler));
+	xmlSAXVersion (&sax, 2);
+	sax.startElementNs = gdav_multi_status_parser_start_element;
+	sax.endElementNs = gdav_multi_status_parser_end_element;
+
+	parser = g_slice_new0 (GDavMultiStatusParser);
+	parser->base_uri = soup_uri_copy (base_uri);
+	parser->multi_status = g_object_new (GDAV_TYPE_MULTI_STATUS, NULL);
+	parser->func = func;
+	parser->user_data = user_data;
+
+	/* Responses passed to a GDavResponseFunc may outlive
+	 * the parser individually, so only use an arena when
+	 * the responses all end up in the GDavMultiStatus. */
+	if (func == NULL) {
+		parser->arena = gdav_arena_new ();
+		parser->multi_status->priv->arena =
+			gdav_arena_ref (parser->arena);
+	}
+
+	/* The SAX handler is copied, so a stack variable is fine. */
+	parser->ctxt = xmlCreatePushParserCtxt (
+		&sax, NULL, NULL, 0, "/dev/null");
+	parser->ctxt->_private = parser;
+
+	/* Never fetch external resources named by the document. */
+	xmlCtxtUseOptions (parser->ctxt, XML_PARSE_NONET);
+
+	parser->tokenizer = gdav_xml_tokenizer_new (parser->ctxt->dict);
+
+	return parser;
+}
+
+static gboolean
+gdav_multi_status_parser_check (GDavMultiStatusParser *parser,
+                                gint xml_status,
+                                GError **error)
+{
+	if (parser->error != NULL) {
+		g_propagate_error (error, parser->error);
+		parser->error = NULL;
+		return FALSE;
+	}
+
+	/* Stopping at the callback's request is not an error. */
+	if (parser->stopped)
+		return TRUE;
+
+	if (xml_status != 0 || !parser->ctxt->wellFormed) {
+		xmlError *xml_error;
+		const gchar *message = NULL;
+
+		xml_error = xmlCtxtGetLastError (parser->ctxt);
+
+		if (xml_error != NULL)
+			message = xml_error->message;
+		if (message == NULL) {
+			/* Translators: This is a fallback in the event
+			 * of an XML parsing error with no error message. */
+			message = _("unspecified");
+		}
+
+		g_set_error (
+			error, GDAV_PARSABLE_ERROR,
+			GDAV_PARSABLE_ERROR_PARSER_FAILED,
+			_("Error parsing XML: %s"), message);
+
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+gboolean
+gdav_multi_status_parser_push (GDavMultiStatusParser *parser,
+                               gconstpointer data,
+                               gsize data_size,
+                               GError **error)
+{
+	gint xml_status;
+
+	g_return_val_if_fail (parser != NULL, FALSE);
+	g_return_val_if_fail (data != NULL || data_size == 0, FALSE);
+
+	/* xmlParseChunk() takes an int size, so feed large
+	 * buffers to it in pieces.  Chunks from the network
+	 * are never anywhere near that big. */
+	while (data_size > 0 && !parser->stopped) {
+		gsize chunk_size = MIN (data_size, G_MAXINT);
+
+		if (parser->arena != NULL)
+			gdav_arena_push_thread_default (parser->arena);
+
+		xml_status = xmlParseChunk (
+			parser->ctxt, data, (gint) chunk_size, 0);
+
+		if (parser->arena != NULL)
+			gdav_arena_pop_thread_default (parser->arena);
+
+		if (!gdav_multi_status_parser_check (
+			parser, xml_status, error))
+			return FALSE;
+
+		data = (const gchar *) data + chunk_size;
+		data_size -= chunk_size;
+	}
+
+	return TRUE;
+}
+
+gboolean
+gdav_multi_status_parser_is_stopped (GDavMultiStatusParser *parser)
+{
+	g_return_val_if_fail (parser != NULL, FALSE);
+
+	return parser->stopped;
+}
+
+GDavMultiStatus *
+gdav_multi_status_parser_finish (GDavMultiStatusParser *parser,
+                                 GError **error)
+{
+	gint xml_status;
+
+	g_return_val_if_fail (parser != NULL, NULL);
+
+	if (!parser->stopped) {
+		if (parser->arena != NULL)
+			gdav_arena_push_thread_default (parser->arena);
+
+		xml_status = xmlParseChunk (parser->ctxt, NULL, 0, 1);
+
+		if (parser->arena != NULL)
+			gdav_arena_pop_thread_default (parser->arena);
+
+		if (!gdav_multi_status_parser_check (
+			parser, xml_status, error))
+			return NULL;
+	}
+
+	if (xmlDocGetRootElement (parser->ctxt->myDoc) == NULL) {
+		g_set_error (
+			error, GDAV_PARSABLE_ERROR,
+			GDAV_PARSABLE_ERROR_EMPTY_DOCUMENT,
+			_("Error parsing XML: %s"),
+			_("Empty document"));
+		return NULL;
+	}
+
+	return g_object_ref (parser->multi_status);
+}
+
+void
+gdav_multi_status_parser_free (GDavMultiStatusParser *parser)
+{
+	if (parser != NULL) {
+		if (parser->ctxt->myDoc != NULL)
+			xmlFreeDoc (parser->ctxt->myDoc);
+		xmlFreeParserCtxt (parser->ctxt);
+		gdav_xml_tokenizer_free (parser->tokenizer);
+
+		soup_uri_free (parser->base_uri);
+
+		if (parser->arena != NULL)
+			gdav_arena_unref (parser->arena);
+		g_clear_object (&parser->multi_status);
+		g_clear_error (&parser->error);
+
+		g_slice_free (GDavMultiStatusParser, parser);
+	}
+}
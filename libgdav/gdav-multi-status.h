@@ -48,6 +48,31 @@ typedef struct _GDavMultiStatus GDavMultiStatus;
 typedef struct _GDavMultiStatusClass GDavMultiStatusClass;
 typedef struct _GDavMultiStatusPrivate GDavMultiStatusPrivate;
 
+/**
+ * GDavMultiStatusParser:
+ *
+ * Incrementally parses a DAV:multistatus document as it arrives.
+ * Each DAV:response element is turned into a #GDavResponse as soon
+ * as its closing tag is seen, and the XML behind it is discarded.
+ * Responses are collected in the resulting #GDavMultiStatus unless
+ * a #GDavResponseFunc is given, in which case they are passed to it
+ * one at a time and never accumulated.
+ **/
+typedef struct _GDavMultiStatusParser GDavMultiStatusParser;
+
+/**
+ * GDavResponseFunc:
+ * @response: a #GDavResponse
+ * @user_data: user data passed along with the function
+ *
+ * Called for each DAV:response element in a multistatus document,
+ * in document order, as soon as the element has been parsed.
+ *
+ * Returns: %TRUE to continue, %FALSE to stop parsing
+ **/
+typedef gboolean	(*GDavResponseFunc)	(GDavResponse *response,
+						 gpointer user_data);
+
 struct _GDavMultiStatus {
 	GDavParsable parent;
 	GDavMultiStatusPrivate *priv;
@@ -69,6 +94,35 @@ guint		gdav_multi_status_get_n_responses
 					(GDavMultiStatus *multi_status);
 const gchar *	gdav_multi_status_get_description
 					(GDavMultiStatus *multi_status);
+const gchar *	gdav_multi_status_get_sync_token
+					(GDavMultiStatus *multi_status);
+gboolean	gdav_multi_status_get_truncated
+					(GDavMultiStatus *multi_status);
+gboolean	gdav_multi_status_diff
+					(GDavMultiStatus *old_status,
+					 GDavMultiStatus *new_status,
+					 GPtrArray **out_added,
+					 GPtrArray **out_removed,
+					 GPtrArray **out_changed);
+
+GDavMultiStatusParser *
+		gdav_multi_status_parser_new
+					(SoupURI *base_uri,
+					 GDavResponseFunc func,
+					 gpointer user_data);
+gboolean	gdav_multi_status_parser_push
+					(GDavMultiStatusParser *parser,
+					 gconstpointer data,
+					 gsize data_size,
+					 GError **error);
+gboolean	gdav_multi_status_parser_is_stopped
+					(GDavMultiStatusParser *parser);
+GDavMultiStatus *
+		gdav_multi_status_parser_finish
+					(GDavMultiStatusParser *parser,
+					 GError **error);
+void		gdav_multi_status_parser_free
+					(GDavMultiStatusParser *parser);
 
 G_END_DECLS
 
@@ -46,6 +46,8 @@ gdav_parsable_real_deserialize (GDavParsable *parsable,
                                 GError **error)
 {
 	/* FIXME Store off unhandled xmlNode. */
+
+	return TRUE;
 }
 
 static void
@@ -78,6 +80,7 @@ gdav_parsable_class_init (GDavParsableClass *class)
 	g_type_ensure (GDAV_TYPE_RESPONSE);
 
 	/* Properties */
+	g_type_ensure (GDAV_TYPE_CALENDAR_DATA_PROPERTY);
 	g_type_ensure (GDAV_TYPE_CALENDAR_DESCRIPTION_PROPERTY);
 	g_type_ensure (GDAV_TYPE_CALENDAR_TIMEZONE_PROPERTY);
 	g_type_ensure (GDAV_TYPE_CREATIONDATE_PROPERTY);
@@ -126,38 +129,104 @@ gdav_parsable_is_a (xmlNode *node,
 	return match;
 }
 
-/* Helper for gdav_parsable_type_from_node() */
-static GType
-parsable_type_from_node_rec (GType parent_type,
-                             xmlNode *node)
+/* Element namespace href -> (element name -> GType) */
+static GHashTable *parsable_types;
+G_LOCK_DEFINE_STATIC (parsable_types);
+
+static GHashTable *
+parsable_types_get_names (const gchar *element_namespace)
+{
+	GHashTable *names;
+
+	names = g_hash_table_lookup (parsable_types, element_namespace);
+
+	if (names == NULL) {
+		names = g_hash_table_new_full (
+			(GHashFunc) g_str_hash,
+			(GEqualFunc) g_str_equal,
+			(GDestroyNotify) g_free,
+			(GDestroyNotify) NULL);
+		g_hash_table_insert (
+			parsable_types,
+			g_strdup (element_namespace), names);
+	}
+
+	return names;
+}
+
+/* Helper for parsable_types_lookup() */
+static void
+parsable_types_add_rec (GType parent_type)
 {
 	GType *children;
 	guint n_children, ii;
-	GType type = G_TYPE_INVALID;
 
 	children = g_type_children (parent_type, &n_children);
 
 	for (ii = 0; ii < n_children; ii++) {
+		GDavParsableClass *class;
+		GHashTable *names;
 		GType child_type;
 
 		child_type = children[ii];
 
-		/* Recurse over the child's children. */
-		type = parsable_type_from_node_rec (child_type, node);
-
-		if (type != G_TYPE_INVALID)
-			break;
+		/* Descendants take precedence over their ancestors,
+		 * so add the child's children first. */
+		parsable_types_add_rec (child_type);
 
 		if (G_TYPE_IS_ABSTRACT (child_type))
 			continue;
 
-		if (gdav_parsable_is_a (node, child_type)) {
-			type = child_type;
-			break;
+		class = g_type_class_ref (child_type);
+
+		g_warn_if_fail (class->element_name != NULL);
+		g_warn_if_fail (class->element_namespace != NULL);
+
+		if (class->element_name != NULL &&
+		    class->element_namespace != NULL) {
+			names = parsable_types_get_names (
+				class->element_namespace);
+			if (!g_hash_table_contains (names, class->element_name))
+				g_hash_table_insert (
+					names,
+					g_strdup (class->element_name),
+					GSIZE_TO_POINTER (child_type));
 		}
+
+		g_type_class_unref (class);
 	}
 
 	g_free (children);
+}
+
+static GType
+parsable_types_lookup (const gchar *element_namespace,
+                       const gchar *element_name)
+{
+	GHashTable *names;
+	GType type = G_TYPE_INVALID;
+
+	G_LOCK (parsable_types);
+
+	/* The table is built from the type hierarchy on first use.
+	 * gdav_parsable_class_init() registers all the built-in types
+	 * up front; any others must be registered before parsing. */
+	if (parsable_types == NULL) {
+		parsable_types = g_hash_table_new_full (
+			(GHashFunc) g_str_hash,
+			(GEqualFunc) g_str_equal,
+			(GDestroyNotify) g_free,
+			(GDestroyNotify) g_hash_table_unref);
+		parsable_types_add_rec (GDAV_TYPE_PARSABLE);
+	}
+
+	names = g_hash_table_lookup (parsable_types, element_namespace);
+
+	if (names != NULL)
+		type = GPOINTER_TO_SIZE (
+			g_hash_table_lookup (names, element_name));
+
+	G_UNLOCK (parsable_types);
 
 	return type;
 }
@@ -180,7 +249,9 @@ gdav_parsable_lookup_type (xmlNode *node,
 		return G_TYPE_INVALID;
 	}
 
-	type = parsable_type_from_node_rec (GDAV_TYPE_PARSABLE, node);
+	type = parsable_types_lookup (
+		(const gchar *) node->ns->href,
+		(const gchar *) node->name);
 
 	if (!g_type_is_a (type, GDAV_TYPE_PARSABLE)) {
 		g_set_error (
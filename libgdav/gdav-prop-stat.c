@@ -23,6 +23,8 @@
 
 #include <glib/gi18n-lib.h>
 
+#include "gdav-xml-tokens.h"
+
 #define GDAV_PROP_STAT_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), GDAV_TYPE_PROP_STAT, GDavPropStatPrivate))
@@ -114,6 +116,7 @@ gdav_prop_stat_finalize (GObject *object)
 
 static gboolean
 gdav_prop_stat_deserialize_dav (GDavParsable *parsable,
+                                GDavXmlToken token,
                                 SoupURI *base_uri,
                                 xmlDoc *doc,
                                 xmlNode *node,
@@ -123,7 +126,7 @@ gdav_prop_stat_deserialize_dav (GDavParsable *parsable,
 
 	priv = GDAV_PROP_STAT_GET_PRIVATE (parsable);
 
-	if (xmlStrcmp (node->name, BAD_CAST "prop") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_PROP) {
 		GDavParsable *item;
 
 		item = gdav_parsable_new_from_xml_node (
@@ -137,7 +140,7 @@ gdav_prop_stat_deserialize_dav (GDavParsable *parsable,
 		return TRUE;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "status") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_STATUS) {
 		xmlChar *text;
 		gboolean success;
 
@@ -164,7 +167,7 @@ gdav_prop_stat_deserialize_dav (GDavParsable *parsable,
 		return success;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "error") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_ERROR) {
 		GDavParsable *item;
 
 		item = gdav_parsable_new_from_xml_node (
@@ -178,7 +181,7 @@ gdav_prop_stat_deserialize_dav (GDavParsable *parsable,
 		return TRUE;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "responsedescription") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_RESPONSEDESCRIPTION) {
 		xmlChar *text;
 
 		text = xmlNodeListGetString (doc, node->children, TRUE);
@@ -201,9 +204,13 @@ gdav_prop_stat_deserialize (GDavParsable *parsable,
                             xmlNode *node,
                             GError **error)
 {
-	if (gdav_is_xmlns (node, GDAV_XMLNS_DAV)) {
+	GDavXmlToken token;
+
+	token = gdav_xml_node_get_token (node);
+
+	if (token != GDAV_XML_TOKEN_OTHER) {
 		return gdav_prop_stat_deserialize_dav (
-			parsable, base_uri, doc, node, error);
+			parsable, token, base_uri, doc, node, error);
 	}
 
 	/* Chain up to parent's deserialize() method. */
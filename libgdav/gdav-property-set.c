@@ -23,14 +23,35 @@
 
 #include "gdav-property.h"
 
+#include "gdav-arena.h"
+
 #define GDAV_PROPERTY_SET_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), GDAV_TYPE_PROPERTY_SET, GDavPropertySetPrivate))
 
+typedef struct _PendingProperty PendingProperty;
+
 struct _GDavPropertySetPrivate {
+	/* Guards the members below.  Even read-only accessors
+	 * build pending values, and a parsed property set may be
+	 * shared between threads through a GDavCache. */
+	GMutex property_lock;
+
 	GHashTable *property_types;
 	GQueue property_values;
+	GArray *pending_values;
+	GDavArena *arena;
 	gboolean names_only;
+	gboolean frozen;
+};
+
+/* A deserialized property whose GDavProperty instance has not been
+ * built yet.  Only used for elements with nothing but text content,
+ * which is all we need to keep to build the instance later. */
+struct _PendingProperty {
+	GType type;
+	const gchar *text;
+	gchar *allocated;
 };
 
 enum {
@@ -86,6 +107,9 @@ gdav_property_set_dispose (GObject *object)
 	while (!g_queue_is_empty (&priv->property_values))
 		g_object_unref (g_queue_pop_head (&priv->property_values));
 
+	if (priv->pending_values != NULL)
+		g_array_set_size (priv->pending_values, 0);
+
 	/* Chain up to parent's dispose() method. */
 	G_OBJECT_CLASS (gdav_property_set_parent_class)->dispose (object);
 }
@@ -99,10 +123,127 @@ gdav_property_set_finalize (GObject *object)
 
 	g_hash_table_destroy (priv->property_types);
 
+	if (priv->pending_values != NULL)
+		g_array_free (priv->pending_values, TRUE);
+
+	g_mutex_clear (&priv->property_lock);
+
+	if (priv->arena != NULL)
+		gdav_arena_unref (priv->arena);
+
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (gdav_property_set_parent_class)->finalize (object);
 }
 
+static void
+pending_property_clear (PendingProperty *pending)
+{
+	g_free (pending->allocated);
+}
+
+static gboolean
+gdav_property_set_node_has_elements (xmlNode *node)
+{
+	xmlNode *child;
+
+	for (child = node->children; child != NULL; child = child->next) {
+		if (child->type == XML_ELEMENT_NODE)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* The following functions must be called with the lock held. */
+
+/* Returns whether any property value, built or pending,
+ * is exactly of type property_type. */
+static gboolean
+gdav_property_set_has_value_of_type (GDavPropertySet *propset,
+                                     GType property_type)
+{
+	GArray *pending_values;
+	GList *link;
+	guint ii, n_pending;
+
+	pending_values = propset->priv->pending_values;
+	n_pending = (pending_values != NULL) ? pending_values->len : 0;
+
+	for (ii = 0; ii < n_pending; ii++) {
+		PendingProperty *pending;
+
+		pending = &g_array_index (pending_values, PendingProperty, ii);
+
+		if (pending->type == property_type)
+			return TRUE;
+	}
+
+	link = g_queue_peek_head_link (&propset->priv->property_values);
+
+	for (; link != NULL; link = g_list_next (link)) {
+		if (G_OBJECT_TYPE (link->data) == property_type)
+			return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Builds GDavProperty instances for any pending
+ * properties that are or derive from property_type. */
+static void
+gdav_property_set_materialize (GDavPropertySet *propset,
+                               GType property_type)
+{
+	GArray *pending_values;
+	guint ii = 0;
+
+	pending_values = propset->priv->pending_values;
+
+	if (pending_values == NULL)
+		return;
+
+	while (ii < pending_values->len) {
+		PendingProperty *pending;
+		GDavProperty *property;
+		GType type;
+		GError *local_error = NULL;
+
+		pending = &g_array_index (pending_values, PendingProperty, ii);
+
+		if (!g_type_is_a (pending->type, property_type)) {
+			ii++;
+			continue;
+		}
+
+		type = pending->type;
+		property = g_object_new (type, NULL);
+
+		if (pending->text != NULL)
+			gdav_property_parse_data (
+				property, pending->text, &local_error);
+
+		/* This frees the text unless it is in the arena. */
+		g_array_remove_index (pending_values, ii);
+
+		/* There's no way to report an error at this point.
+		 * Drop a malformed value rather than pass along its
+		 * default value as if the server had sent it. */
+		if (local_error != NULL) {
+			g_debug ("%s: %s", G_STRFUNC, local_error->message);
+			g_error_free (local_error);
+			g_object_unref (property);
+
+			if (!gdav_property_set_has_value_of_type (propset, type))
+				g_hash_table_remove (
+					propset->priv->property_types,
+					GSIZE_TO_POINTER (type));
+			continue;
+		}
+
+		g_queue_push_tail (&propset->priv->property_values, property);
+	}
+}
+
 static gboolean
 gdav_property_set_serialize (GDavParsable *parsable,
                              GHashTable *namespaces,
@@ -130,26 +271,39 @@ gdav_property_set_serialize (GDavParsable *parsable,
 	if (priv->names_only)
 		goto names_only;
 
+	g_mutex_lock (&priv->property_lock);
+
+	gdav_property_set_materialize (
+		GDAV_PROPERTY_SET (parsable), GDAV_TYPE_PROPERTY);
+
 	list = g_queue_peek_head_link (&priv->property_values);
 
 	for (link = list; link != NULL; link = g_list_next (link)) {
 		success = gdav_parsable_serialize (
-			parsable, namespaces, doc, node, error);
+			GDAV_PARSABLE (link->data),
+			namespaces, doc, node, error);
 		if (!success)
 			break;
 	}
 
+	g_mutex_unlock (&priv->property_lock);
+
 	return success;
 
 names_only:
 
+	g_mutex_lock (&priv->property_lock);
+
 	g_hash_table_iter_init (&iter, priv->property_types);
 
 	while (g_hash_table_iter_next (&iter, &key, NULL)) {
 		GType type = GPOINTER_TO_SIZE (key);
 
-		g_return_val_if_fail (
-			g_type_is_a (type, GDAV_TYPE_PARSABLE), FALSE);
+		if (!g_type_is_a (type, GDAV_TYPE_PARSABLE)) {
+			g_warn_if_reached ();
+			success = FALSE;
+			break;
+		}
 
 		class = g_type_class_ref (type);
 
@@ -161,7 +315,9 @@ names_only:
 		g_type_class_unref (class);
 	}
 
-	return TRUE;
+	g_mutex_unlock (&priv->property_lock);
+
+	return success;
 }
 
 static gboolean
@@ -179,7 +335,70 @@ gdav_property_set_deserialize (GDavParsable *parsable,
 	/* Be lenient about unrecognized properties. */
 	type = gdav_parsable_lookup_type (node, NULL);
 
-	if (g_type_is_a (type, GDAV_TYPE_PROPERTY)) {
+	if (!g_type_is_a (type, GDAV_TYPE_PROPERTY)) {
+		/* Chain up to parent's deserialize() method. */
+		return GDAV_PARSABLE_CLASS (gdav_property_set_parent_class)->
+			deserialize (parsable, base_uri, doc, node, error);
+	}
+
+	/* Most callers only look at one or two properties in a set,
+	 * so put off building a GDavProperty for elements that are
+	 * just text until someone asks for that type.  Properties
+	 * with child elements are built right away. */
+	if (!gdav_property_set_node_has_elements (node)) {
+		PendingProperty pending;
+		xmlNode *child = node->children;
+
+		if (priv->pending_values == NULL) {
+			priv->pending_values = g_array_new (
+				FALSE, FALSE, sizeof (PendingProperty));
+			g_array_set_clear_func (
+				priv->pending_values,
+				(GDestroyNotify) pending_property_clear);
+		}
+
+		pending.type = type;
+		pending.text = NULL;
+		pending.allocated = NULL;
+
+		/* A lone text node is by far the common case,
+		 * and its content can be used without a copy. */
+		if (child != NULL && child->type == XML_TEXT_NODE &&
+		    child->next == NULL) {
+			pending.text = (const gchar *) child->content;
+		} else if (child != NULL) {
+			pending.allocated = (gchar *) xmlNodeListGetString (
+				doc, node->children, TRUE);
+			pending.text = pending.allocated;
+		}
+
+		/* The XML tree is freed once we return, so the text
+		 * has to be copied somewhere.  Use the arena of the
+		 * result being parsed, if there is one. */
+		if (priv->arena == NULL) {
+			GDavArena *arena;
+
+			arena = gdav_arena_get_thread_default ();
+			if (arena != NULL)
+				priv->arena = gdav_arena_ref (arena);
+		}
+
+		if (priv->arena != NULL) {
+			pending.text = gdav_arena_strdup (
+				priv->arena, pending.text);
+			g_free (pending.allocated);
+			pending.allocated = NULL;
+		} else if (pending.allocated == NULL) {
+			pending.allocated = g_strdup (pending.text);
+			pending.text = pending.allocated;
+		}
+
+		g_array_append_val (priv->pending_values, pending);
+
+		gdav_property_set_add_type (
+			GDAV_PROPERTY_SET (parsable), type);
+
+	} else {
 		GDavProperty *property;
 
 		property = gdav_parsable_new_from_xml_node (
@@ -191,13 +410,9 @@ gdav_property_set_deserialize (GDavParsable *parsable,
 			GDAV_PROPERTY_SET (parsable), property);
 
 		g_object_unref (property);
-
-		return TRUE;
 	}
 
-	/* Chain up to parent's deserialize() method. */
-	GDAV_PARSABLE_CLASS (gdav_property_set_parent_class)->
-		deserialize (parsable, base_uri, doc, node, error);
+	return TRUE;
 }
 
 static void
@@ -214,10 +429,14 @@ gdav_property_set_collect_types (GDavParsable *parsable,
 	 * is also added to 'property_types'.  So we don't need
 	 * to iterate over 'property_values' here. */
 
+	g_mutex_lock (&priv->property_lock);
+
 	g_hash_table_iter_init (&iter, priv->property_types);
 
 	while (g_hash_table_iter_next (&iter, &key, NULL))
 		g_hash_table_add (parsable_types, key);
+
+	g_mutex_unlock (&priv->property_lock);
 }
 
 static void
@@ -260,6 +479,8 @@ gdav_property_set_init (GDavPropertySet *propset)
 {
 	propset->priv = GDAV_PROPERTY_SET_GET_PRIVATE (propset);
 
+	g_mutex_init (&propset->priv->property_lock);
+
 	propset->priv->property_types = g_hash_table_new (NULL, NULL);
 }
 
@@ -274,12 +495,17 @@ gdav_property_set_add_type (GDavPropertySet *propset,
                             GType property_type)
 {
 	g_return_if_fail (GDAV_IS_PROPERTY_SET (propset));
+	g_return_if_fail (!propset->priv->frozen);
 	g_return_if_fail (!G_TYPE_IS_ABSTRACT (property_type));
 	g_return_if_fail (g_type_is_a (property_type, GDAV_TYPE_PROPERTY));
 
+	g_mutex_lock (&propset->priv->property_lock);
+
 	g_hash_table_add (
 		propset->priv->property_types,
 		GSIZE_TO_POINTER (property_type));
+
+	g_mutex_unlock (&propset->priv->property_lock);
 }
 
 gboolean
@@ -291,9 +517,17 @@ gdav_property_set_has_type (GDavPropertySet *propset,
 	g_return_val_if_fail (GDAV_IS_PROPERTY_SET (propset), FALSE);
 
 	if (g_type_is_a (property_type, GDAV_TYPE_PROPERTY)) {
+		g_mutex_lock (&propset->priv->property_lock);
+
+		/* A pending value that turns out to be
+		 * malformed takes its type away with it. */
+		gdav_property_set_materialize (propset, property_type);
+
 		has_type = g_hash_table_contains (
 			propset->priv->property_types,
 			GSIZE_TO_POINTER (property_type));
+
+		g_mutex_unlock (&propset->priv->property_lock);
 	}
 
 	return has_type;
@@ -304,13 +538,18 @@ gdav_property_set_add (GDavPropertySet *propset,
                        GDavProperty *property)
 {
 	g_return_if_fail (GDAV_IS_PROPERTY_SET (propset));
+	g_return_if_fail (!propset->priv->frozen);
 	g_return_if_fail (GDAV_IS_PROPERTY (property));
 
 	gdav_property_set_add_type (propset, G_OBJECT_TYPE (property));
 
+	g_mutex_lock (&propset->priv->property_lock);
+
 	g_queue_push_tail (
 		&propset->priv->property_values,
 		g_object_ref (property));
+
+	g_mutex_unlock (&propset->priv->property_lock);
 }
 
 GList *
@@ -322,8 +561,9 @@ gdav_property_set_list (GDavPropertySet *propset,
 
 	g_return_val_if_fail (GDAV_IS_PROPERTY_SET (propset), NULL);
 
-	/* XXX Return new property references in case we want
-	 *     to make this function thread-safe in the future. */
+	g_mutex_lock (&propset->priv->property_lock);
+
+	gdav_property_set_materialize (propset, property_type);
 
 	list = g_queue_peek_head_link (&propset->priv->property_values);
 
@@ -338,6 +578,8 @@ gdav_property_set_list (GDavPropertySet *propset,
 		}
 	}
 
+	g_mutex_unlock (&propset->priv->property_lock);
+
 	return g_queue_peek_head_link (&matches);
 }
 
@@ -348,15 +590,81 @@ gdav_property_set_list_all (GDavPropertySet *propset)
 
 	g_return_val_if_fail (GDAV_IS_PROPERTY_SET (propset), NULL);
 
-	/* XXX Return new property references in case we want
-	 *     to make this function thread-safe in the future. */
+	g_mutex_lock (&propset->priv->property_lock);
+
+	gdav_property_set_materialize (propset, GDAV_TYPE_PROPERTY);
 
 	list = g_queue_peek_head_link (&propset->priv->property_values);
 	list = g_list_copy_deep (list, (GCopyFunc) g_object_ref, NULL);
 
+	g_mutex_unlock (&propset->priv->property_lock);
+
 	return list;
 }
 
+/**
+ * gdav_property_set_peek:
+ * @propset: a #GDavPropertySet
+ * @property_type: a #GDavProperty subtype
+ *
+ * Like gdav_property_set_list() but returns only the first matching
+ * property, without adding a reference or allocating a list.  The
+ * property stays valid for as long as @propset; properties are only
+ * ever added, never removed.
+ *
+ * Returns: a #GDavProperty owned by @propset, or %NULL
+ **/
+GDavProperty *
+gdav_property_set_peek (GDavPropertySet *propset,
+                        GType property_type)
+{
+	GDavProperty *property = NULL;
+	GList *link;
+
+	g_return_val_if_fail (GDAV_IS_PROPERTY_SET (propset), NULL);
+
+	g_mutex_lock (&propset->priv->property_lock);
+
+	gdav_property_set_materialize (propset, property_type);
+
+	link = g_queue_peek_head_link (&propset->priv->property_values);
+
+	for (; link != NULL; link = g_list_next (link)) {
+		if (g_type_is_a (G_OBJECT_TYPE (link->data), property_type)) {
+			property = GDAV_PROPERTY (link->data);
+			break;
+		}
+	}
+
+	g_mutex_unlock (&propset->priv->property_lock);
+
+	return property;
+}
+
+/**
+ * gdav_property_set_freeze:
+ * @propset: a #GDavPropertySet
+ *
+ * Makes @propset immutable.  Properties and property types can no
+ * longer be added, which allows request bodies built from @propset
+ * to be cached and reused.  A frozen property set cannot be thawed.
+ **/
+void
+gdav_property_set_freeze (GDavPropertySet *propset)
+{
+	g_return_if_fail (GDAV_IS_PROPERTY_SET (propset));
+
+	propset->priv->frozen = TRUE;
+}
+
+gboolean
+gdav_property_set_is_frozen (GDavPropertySet *propset)
+{
+	g_return_val_if_fail (GDAV_IS_PROPERTY_SET (propset), FALSE);
+
+	return propset->priv->frozen;
+}
+
 gboolean
 gdav_property_set_get_names_only (GDavPropertySet *propset)
 {
@@ -70,6 +70,10 @@ void		gdav_property_set_add		(GDavPropertySet *propset,
 GList *		gdav_property_set_list		(GDavPropertySet *propset,
 						 GType property_type);
 GList *		gdav_property_set_list_all	(GDavPropertySet *propset);
+GDavProperty *	gdav_property_set_peek		(GDavPropertySet *propset,
+						 GType property_type);
+void		gdav_property_set_freeze	(GDavPropertySet *propset);
+gboolean	gdav_property_set_is_frozen	(GDavPropertySet *propset);
 gboolean	gdav_property_set_get_names_only
 						(GDavPropertySet *propset);
 void		gdav_property_set_set_names_only
@@ -21,6 +21,8 @@
 
 #include "gdav-property.h"
 
+#include <glib/gi18n-lib.h>
+
 #define GDAV_PROPERTY_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), GDAV_TYPE_PROPERTY, GDavPropertyPrivate))
@@ -43,8 +45,15 @@ gdav_property_meta_set_value (GDavProperty *property,
 	/* Copying a GValue containing the real property value,
 	 * hence the "meta". */
 
-	if (value != NULL)
+	if (value != NULL) {
+		/* This is a construct-only property, so we
+		 * get here before constructed() is called. */
+		if (!G_IS_VALUE (&property->priv->value))
+			g_value_init (
+				&property->priv->value,
+				GDAV_PROPERTY_GET_CLASS (property)->value_type);
 		g_value_copy (value, &property->priv->value);
+	}
 }
 
 static GValue *
@@ -126,12 +135,78 @@ gdav_property_constructed (GObject *object)
 	class = GDAV_PROPERTY_GET_CLASS (object);
 	priv = GDAV_PROPERTY_GET_PRIVATE (object);
 
-	g_value_init (&priv->value, class->value_type);
+	if (!G_IS_VALUE (&priv->value))
+		g_value_init (&priv->value, class->value_type);
 
 	/* Chain up to parent's constructed() method. */
 	G_OBJECT_CLASS (gdav_property_parent_class)->constructed (object);
 }
 
+static gboolean
+gdav_property_real_parse_data (GDavProperty *property,
+                               const gchar *data,
+                               GValue *result,
+                               GError **error)
+{
+	GType value_type;
+	gchar *text;
+	gboolean success = TRUE;
+
+	value_type = G_VALUE_TYPE (result);
+
+	if (value_type == G_TYPE_STRING) {
+		g_value_set_string (result, data);
+		return TRUE;
+	}
+
+	text = g_strstrip (g_strdup (data));
+
+	if (value_type == G_TYPE_UINT64) {
+		gchar *endptr = NULL;
+		guint64 number;
+
+		number = g_ascii_strtoull (text, &endptr, 10);
+		success = (*text != '\0' && endptr != NULL && *endptr == '\0');
+
+		if (success) {
+			g_value_set_uint64 (result, number);
+		} else {
+			g_set_error (
+				error, GDAV_PARSABLE_ERROR,
+				GDAV_PARSABLE_ERROR_INTERNAL,
+				_("Invalid number '%s'"), text);
+		}
+
+	} else if (value_type == G_TYPE_DATE_TIME) {
+		SoupDate *date;
+
+		/* Handles both RFC 1123 (DAV:getlastmodified)
+		 * and RFC 3339 (DAV:creationdate) formats. */
+		date = soup_date_new_from_string (text);
+		success = (date != NULL);
+
+		if (success) {
+			g_value_take_boxed (
+				result,
+				g_date_time_new_from_unix_utc (
+				soup_date_to_time_t (date)));
+			soup_date_free (date);
+		} else {
+			g_set_error (
+				error, GDAV_PARSABLE_ERROR,
+				GDAV_PARSABLE_ERROR_INTERNAL,
+				_("Invalid date '%s'"), text);
+		}
+	}
+
+	/* Any other value type is built from child elements
+	 * by the subclass, so there's nothing to parse here. */
+
+	g_free (text);
+
+	return success;
+}
+
 static void
 gdav_property_class_init (GDavPropertyClass *class)
 {
@@ -146,6 +221,8 @@ gdav_property_class_init (GDavPropertyClass *class)
 	object_class->finalize = gdav_property_finalize;
 	object_class->constructed = gdav_property_constructed;
 
+	class->parse_data = gdav_property_real_parse_data;
+
 	g_object_class_install_property (
 		object_class,
 		PROP_VALUE,
@@ -176,6 +253,23 @@ gdav_property_get_value (GDavProperty *property,
 	g_value_copy (&property->priv->value, value);
 }
 
+/**
+ * gdav_property_peek_value:
+ * @property: a #GDavProperty
+ *
+ * Returns the property value without copying it.  The #GValue is
+ * owned by @property and must not be modified.
+ *
+ * Returns: the property value
+ **/
+const GValue *
+gdav_property_peek_value (GDavProperty *property)
+{
+	g_return_val_if_fail (GDAV_IS_PROPERTY (property), NULL);
+
+	return &property->priv->value;
+}
+
 gboolean
 gdav_property_set_value (GDavProperty *property,
                          const GValue *value)
@@ -186,3 +280,19 @@ gdav_property_set_value (GDavProperty *property,
 	return g_value_transform (value, &property->priv->value);
 }
 
+gboolean
+gdav_property_parse_data (GDavProperty *property,
+                          const gchar *data,
+                          GError **error)
+{
+	GDavPropertyClass *class;
+
+	g_return_val_if_fail (GDAV_IS_PROPERTY (property), FALSE);
+	g_return_val_if_fail (data != NULL, FALSE);
+
+	class = GDAV_PROPERTY_GET_CLASS (property);
+	g_return_val_if_fail (class->parse_data != NULL, FALSE);
+
+	return class->parse_data (
+		property, data, &property->priv->value, error);
+}
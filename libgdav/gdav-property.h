@@ -66,8 +66,12 @@ struct _GDavPropertyClass {
 GType		gdav_property_get_type		(void) G_GNUC_CONST;
 void		gdav_property_get_value		(GDavProperty *property,
 						 GValue *value);
+const GValue *	gdav_property_peek_value	(GDavProperty *property);
 gboolean	gdav_property_set_value		(GDavProperty *property,
 						 const GValue *value);
+gboolean	gdav_property_parse_data	(GDavProperty *property,
+						 const gchar *data,
+						 GError **error);
 
 #endif /* __GDAV_PROPERTY_H__ */
 
@@ -21,7 +21,12 @@
 
 #include "gdav-requests.h"
 
+#include "gdav-cache-private.h"
+#include "gdav-calendar-data-property.h"
+#include "gdav-getetag-property.h"
+
 #define XC_ALLPROP		(BAD_CAST "allprop")
+#define XC_CALENDAR_MULTIGET	(BAD_CAST "calendar-multiget")
 #define XC_EXCLUSIVE		(BAD_CAST "exclusive")
 #define XC_HREF			(BAD_CAST "href")
 #define XC_LOCKINFO		(BAD_CAST "lockinfo")
@@ -32,8 +37,16 @@
 #define XC_PROPFIND		(BAD_CAST "propfind")
 #define XC_PROPNAME		(BAD_CAST "propname")
 #define XC_SHARED		(BAD_CAST "shared")
+#define XC_SYNC_COLLECTION	(BAD_CAST "sync-collection")
+#define XC_SYNC_LEVEL		(BAD_CAST "sync-level")
+#define XC_SYNC_TOKEN		(BAD_CAST "sync-token")
 #define XC_WRITE		(BAD_CAST "write")
 
+/* libsoup has no constant for this one. */
+#define GDAV_METHOD_REPORT	"REPORT"
+
+static G_DEFINE_QUARK (gdav-propfind-body, propfind_body)
+
 static xmlNs *
 gdav_nsdav_new (xmlNode *root)
 {
@@ -135,16 +148,56 @@ gdav_namespaces_ht_collect (GHashTable *namespaces,
 	g_hash_table_destroy (parsable_types);
 }
 
+static gboolean
+gdav_method_is_safe (const gchar *method)
+{
+	return	(method == SOUP_METHOD_GET) ||
+		(method == SOUP_METHOD_HEAD) ||
+		(method == SOUP_METHOD_OPTIONS) ||
+		(method == SOUP_METHOD_PROPFIND) ||
+		(g_strcmp0 (method, GDAV_METHOD_REPORT) == 0);
+}
+
+static void
+gdav_request_invalidate_cache (SoupRequestHTTP *request,
+                               const gchar *uri_string)
+{
+	SoupSession *session;
+	GDavCache *cache;
+	SoupURI *uri;
+
+	session = soup_request_get_session (SOUP_REQUEST (request));
+	cache = gdav_cache_get_for_session (session);
+
+	if (cache == NULL)
+		return;
+
+	uri = soup_uri_new_with_base (
+		soup_request_get_uri (SOUP_REQUEST (request)), uri_string);
+
+	if (uri != NULL) {
+		gdav_cache_invalidate (cache, uri);
+		soup_uri_free (uri);
+	}
+}
+
 static void
 gdav_init_basic_request (SoupRequestHTTP *request)
 {
 	SoupMessage *message;
+	SoupSession *session;
+	GDavCache *cache;
 
 	message = soup_request_http_get_message (request);
 
+	session = soup_request_get_session (SOUP_REQUEST (request));
+	cache = gdav_cache_get_for_session (session);
+
 	/* Add headers common to all requests. */
 
-	/* See RFC 4918 (WebDAV) Section 10.4.5 */
+	/* See RFC 4918 (WebDAV) Section 10.4.5.  This holds even
+	 * with a GDavCache attached; its conditional requests still
+	 * reach the server, they just get a 304 back. */
 	soup_message_headers_replace (
 		message->request_headers,
 		"Cache-Control", "no-cache");
@@ -152,6 +205,11 @@ gdav_init_basic_request (SoupRequestHTTP *request)
 		message->request_headers,
 		"Pragma", "no-cache");
 
+	/* Forget about anything this request may change.  Doing
+	 * it up front is harmless if the request ends up failing. */
+	if (cache != NULL && !gdav_method_is_safe (message->method))
+		gdav_cache_invalidate (cache, soup_message_get_uri (message));
+
 	g_object_unref (message);
 }
 
@@ -231,26 +289,127 @@ gdav_request_write_body (SoupMessage *message,
                          xmlDoc *doc,
                          xmlNode *root)
 {
-	xmlOutputBuffer *buffer;
-	gconstpointer content;
+	xmlBuffer *buffer;
 	gsize size;
+	gpointer content;
 
-	buffer = xmlAllocOutputBuffer (NULL);
-	xmlNodeDumpOutput (buffer, doc, root, 0, 1, NULL);
-	xmlOutputBufferFlush (buffer);
+	buffer = xmlBufferCreate ();
+	xmlNodeDump (buffer, doc, root, 0, 1);
 
-#ifdef LIBXML2_NEW_BUFFER
-	content = xmlOutputBufferGetContent (buffer);
-	size = xmlOutputBufferGetSize (buffer);
-#else
-	content = buffer->buffer->content;
-	size = buffer->buffer->use;
-#endif
+	/* libxml allocates with g_malloc(), as set up in
+	 * gdav_parsable_class_init(), so libsoup can take
+	 * the buffer content as-is. */
+	size = xmlBufferLength (buffer);
+	content = xmlBufferDetach (buffer);
 
 	soup_message_set_request (
-		message, "application/xml", SOUP_MEMORY_COPY, content, size);
+		message, "application/xml", SOUP_MEMORY_TAKE, content, size);
+
+	xmlBufferFree (buffer);
+}
+
+/* The request bodies below are small and fixed in shape, so they
+ * are written straight into a GString rather than built as an XML
+ * tree and then dumped.  Element names are all known to be valid,
+ * so only character data needs escaping. */
+
+static void
+gdav_xml_body_append_text (GString *body,
+                           const gchar *text)
+{
+	for (; *text != '\0'; text++) {
+		switch (*text) {
+			case '<':
+				g_string_append (body, "&lt;");
+				break;
+			case '>':
+				g_string_append (body, "&gt;");
+				break;
+			case '&':
+				g_string_append (body, "&amp;");
+				break;
+			default:
+				g_string_append_c (body, *text);
+				break;
+		}
+	}
+}
+
+static void
+gdav_xml_body_start_element (GString *body,
+                             const gchar *prefix,
+                             const gchar *name)
+{
+	g_string_append_printf (body, "<%s:%s>", prefix, name);
+}
+
+static void
+gdav_xml_body_end_element (GString *body,
+                           const gchar *prefix,
+                           const gchar *name)
+{
+	g_string_append_printf (body, "</%s:%s>", prefix, name);
+}
+
+static void
+gdav_xml_body_append_element (GString *body,
+                              const gchar *prefix,
+                              const gchar *name,
+                              const gchar *text)
+{
+	if (text == NULL) {
+		g_string_append_printf (body, "<%s:%s/>", prefix, name);
+	} else {
+		gdav_xml_body_start_element (body, prefix, name);
+		gdav_xml_body_append_text (body, text);
+		gdav_xml_body_end_element (body, prefix, name);
+	}
+}
+
+static void
+gdav_xml_body_append_xmlns (GString *body,
+                            const gchar *ns_href,
+                            const gchar *ns_prefix)
+{
+	g_string_append_printf (body, " xmlns:%s=\"", ns_prefix);
+	gdav_xml_body_append_text (body, ns_href);
+	g_string_append_c (body, '"');
+}
 
-	xmlOutputBufferClose (buffer);
+/* Attaches the body by reference, so many
+ * requests can share one immutable buffer. */
+static void
+gdav_request_set_body_bytes (SoupMessage *message,
+                             GBytes *bytes)
+{
+	SoupBuffer *buffer;
+	gconstpointer data;
+	gsize size;
+
+	data = g_bytes_get_data (bytes, &size);
+
+	buffer = soup_buffer_new_with_owner (
+		data, size, g_bytes_ref (bytes),
+		(GDestroyNotify) g_bytes_unref);
+
+	soup_message_headers_replace (
+		message->request_headers,
+		"Content-Type", "application/xml");
+	soup_message_body_truncate (message->request_body);
+	soup_message_body_append_buffer (message->request_body, buffer);
+
+	soup_buffer_free (buffer);
+}
+
+static void
+gdav_request_take_body (SoupMessage *message,
+                        GString *body)
+{
+	gsize size = body->len;
+
+	soup_message_set_request (
+		message, "application/xml", SOUP_MEMORY_TAKE,
+		g_string_free (body, FALSE), size);
 }
 
 SoupRequestHTTP *
@@ -291,6 +450,331 @@ gdav_request_options_uri (SoupSession *session,
 	return request;
 }
 
+SoupRequestHTTP *
+gdav_request_get (SoupSession *session,
+                  const gchar *uri_string,
+                  GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri_string != NULL, NULL);
+
+	request = soup_session_request_http (
+		session, SOUP_METHOD_GET, uri_string, error);
+
+	if (request != NULL)
+		gdav_init_basic_request (request);
+
+	return request;
+}
+
+SoupRequestHTTP *
+gdav_request_get_uri (SoupSession *session,
+                      SoupURI *uri,
+                      GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	request = soup_session_request_http_uri (
+		session, SOUP_METHOD_GET, uri, error);
+
+	if (request != NULL)
+		gdav_init_basic_request (request);
+
+	return request;
+}
+
+static void
+gdav_init_put_request (SoupRequestHTTP *request,
+                       goffset content_length,
+                       const gchar *content_type,
+                       const gchar *if_match,
+                       GDavPutFlags flags)
+{
+	SoupMessage *message;
+	SoupMessageHeaders *headers;
+
+	gdav_init_basic_request (request);
+
+	message = soup_request_http_get_message (request);
+	headers = message->request_headers;
+
+	if (content_length >= 0) {
+		soup_message_headers_set_content_length (
+			headers, content_length);
+	} else {
+		soup_message_headers_set_encoding (
+			headers, SOUP_ENCODING_CHUNKED);
+	}
+
+	if (content_type != NULL)
+		soup_message_headers_replace (
+			headers, "Content-Type", content_type);
+
+	if (if_match != NULL)
+		soup_message_headers_replace (
+			headers, "If-Match", if_match);
+
+	if (flags & GDAV_PUT_FLAGS_NO_OVERWRITE)
+		soup_message_headers_replace (
+			headers, "If-None-Match", "*");
+
+	/* Let the server turn the request down before
+	 * we start sending what may be a large body. */
+	soup_message_headers_set_expectations (
+		headers, SOUP_EXPECTATION_CONTINUE);
+
+	g_object_unref (message);
+}
+
+SoupRequestHTTP *
+gdav_request_put (SoupSession *session,
+                  const gchar *uri_string,
+                  goffset content_length,
+                  const gchar *content_type,
+                  const gchar *if_match,
+                  GDavPutFlags flags,
+                  GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri_string != NULL, NULL);
+
+	request = soup_session_request_http (
+		session, SOUP_METHOD_PUT, uri_string, error);
+
+	if (request != NULL)
+		gdav_init_put_request (
+			request, content_length,
+			content_type, if_match, flags);
+
+	return request;
+}
+
+SoupRequestHTTP *
+gdav_request_put_uri (SoupSession *session,
+                      SoupURI *uri,
+                      goffset content_length,
+                      const gchar *content_type,
+                      const gchar *if_match,
+                      GDavPutFlags flags,
+                      GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+
+	request = soup_session_request_http_uri (
+		session, SOUP_METHOD_PUT, uri, error);
+
+	if (request != NULL)
+		gdav_init_put_request (
+			request, content_length,
+			content_type, if_match, flags);
+
+	return request;
+}
+
+/* Writes the start of a root element declaring every namespace
+ * in 'prop', then 'preamble', then the DAV:prop element.  The
+ * caller closes the root element. */
+static void
+gdav_write_prop_body (GString *body,
+                      const gchar *dav_prefix,
+                      const gchar *root_namespace,
+                      const gchar *root_name,
+                      const gchar *preamble,
+                      GDavPropertySet *prop)
+{
+	GDavParsableClass *prop_class;
+	GHashTable *parsable_types;
+	GHashTable *namespaces;
+	GHashTableIter iter;
+	GQueue elements = G_QUEUE_INIT;
+	gpointer key, value;
+
+	parsable_types = g_hash_table_new (NULL, NULL);
+	gdav_parsable_collect_types (GDAV_PARSABLE (prop), parsable_types);
+
+	/* Maps namespace href to prefix, for the root element. */
+	namespaces = g_hash_table_new (g_str_hash, g_str_equal);
+
+	g_hash_table_iter_init (&iter, parsable_types);
+
+	while (g_hash_table_iter_next (&iter, &key, NULL)) {
+		GType type = GPOINTER_TO_SIZE (key);
+		GDavParsableClass *class;
+		const gchar *ns_prefix = NULL;
+
+		if (!g_type_is_a (type, GDAV_TYPE_PARSABLE)) {
+			g_warning (
+				"Non-parsable type %s collected from %s",
+				g_type_name (type),
+				G_OBJECT_TYPE_NAME (prop));
+			continue;
+		}
+
+		/* The property set itself is collected too.  Only
+		 * properties belong inside the DAV:prop element. */
+		if (!g_type_is_a (type, GDAV_TYPE_PROPERTY))
+			continue;
+
+		class = g_type_class_ref (type);
+
+		if (class->element_namespace == NULL) {
+			g_warning (
+				"No element_namespace in %sClass",
+				G_OBJECT_CLASS_NAME (class));
+		} else {
+			ns_prefix = gdav_get_xmlns_prefix (
+				class->element_namespace);
+			if (ns_prefix == NULL)
+				g_warning (
+					"No prefix for namespace '%s'",
+					class->element_namespace);
+		}
+
+		if (ns_prefix != NULL) {
+			g_hash_table_replace (
+				namespaces,
+				(gpointer) class->element_namespace,
+				(gpointer) ns_prefix);
+			g_queue_push_tail (&elements, class);
+		} else {
+			g_type_class_unref (class);
+		}
+	}
+
+	g_hash_table_replace (
+		namespaces, (gpointer) root_namespace,
+		(gpointer) gdav_get_xmlns_prefix (root_namespace));
+	g_hash_table_remove (namespaces, GDAV_XMLNS_DAV);
+
+	g_string_append_printf (
+		body, "<%s:%s",
+		gdav_get_xmlns_prefix (root_namespace), root_name);
+	gdav_xml_body_append_xmlns (body, GDAV_XMLNS_DAV, dav_prefix);
+
+	g_hash_table_iter_init (&iter, namespaces);
+
+	while (g_hash_table_iter_next (&iter, &key, &value))
+		gdav_xml_body_append_xmlns (body, key, value);
+
+	g_string_append_c (body, '>');
+
+	if (preamble != NULL)
+		g_string_append (body, preamble);
+
+	prop_class = GDAV_PARSABLE_GET_CLASS (prop);
+
+	gdav_xml_body_start_element (
+		body, dav_prefix, prop_class->element_name);
+
+	while (!g_queue_is_empty (&elements)) {
+		GDavParsableClass *class;
+
+		class = g_queue_pop_head (&elements);
+
+		gdav_xml_body_append_element (
+			body,
+			gdav_get_xmlns_prefix (class->element_namespace),
+			class->element_name, NULL);
+
+		g_type_class_unref (class);
+	}
+
+	gdav_xml_body_end_element (
+		body, dav_prefix, prop_class->element_name);
+
+	g_hash_table_destroy (namespaces);
+	g_hash_table_destroy (parsable_types);
+}
+
+static GString *
+gdav_propfind_body_new (GDavPropFindType type,
+                        GDavPropertySet *prop)
+{
+	GString *body;
+	const gchar *dav_prefix;
+
+	dav_prefix = gdav_get_xmlns_prefix (GDAV_XMLNS_DAV);
+	g_warn_if_fail (dav_prefix != NULL);
+
+	body = g_string_sized_new (256);
+
+	/* Only property names are sent, so the property set is
+	 * written from its types and its values never matter. */
+	if (type == GDAV_PROPFIND_PROP) {
+		gdav_write_prop_body (
+			body, dav_prefix, GDAV_XMLNS_DAV,
+			(gchar *) XC_PROPFIND, NULL, prop);
+	} else {
+		g_string_append_printf (
+			body, "<%s:%s", dav_prefix, (gchar *) XC_PROPFIND);
+		gdav_xml_body_append_xmlns (body, GDAV_XMLNS_DAV, dav_prefix);
+		g_string_append_c (body, '>');
+
+		switch (type) {
+			case GDAV_PROPFIND_ALLPROP:
+				gdav_xml_body_append_element (
+					body, dav_prefix,
+					(gchar *) XC_ALLPROP, NULL);
+				break;
+
+			case GDAV_PROPFIND_PROPNAME:
+				gdav_xml_body_append_element (
+					body, dav_prefix,
+					(gchar *) XC_PROPNAME, NULL);
+				break;
+
+			default:
+				g_warn_if_reached ();
+		}
+	}
+
+	gdav_xml_body_end_element (
+		body, dav_prefix, (gchar *) XC_PROPFIND);
+
+	return body;
+}
+
+/* Returns the PROPFIND body for a frozen property set, building
+ * it on first use and keeping it on the property set after that. */
+static GBytes *
+gdav_propfind_body_ref_cached (GDavPropertySet *prop)
+{
+	GBytes *bytes;
+	GString *body;
+	gsize size;
+
+	bytes = g_object_dup_qdata (
+		G_OBJECT (prop), propfind_body_quark (),
+		(GDuplicateFunc) g_bytes_ref, NULL);
+
+	if (bytes != NULL)
+		return bytes;
+
+	body = gdav_propfind_body_new (GDAV_PROPFIND_PROP, prop);
+	size = body->len;
+	bytes = g_bytes_new_take (g_string_free (body, FALSE), size);
+
+	/* If another thread got there first, keep theirs
+	 * cached and just use ours for this one request. */
+	g_bytes_ref (bytes);
+	if (!g_object_replace_qdata (
+		G_OBJECT (prop), propfind_body_quark (),
+		NULL, bytes, (GDestroyNotify) g_bytes_unref, NULL))
+		g_bytes_unref (bytes);
+
+	return bytes;
+}
+
 static gboolean
 gdav_init_propfind_request (SoupRequestHTTP *request,
                             GDavPropFindType type,
@@ -299,11 +783,6 @@ gdav_init_propfind_request (SoupRequestHTTP *request,
                             GError **error)
 {
 	SoupMessage *message;
-	GHashTable *namespaces;
-	xmlDoc *doc;
-	xmlNode *root;
-	xmlNs *nsdav;
-	gboolean success = TRUE;
 
 	/* Gracefully resolve type/prop disagreement. */
 	if (type == GDAV_PROPFIND_PROP && prop == NULL)
@@ -315,46 +794,21 @@ gdav_init_propfind_request (SoupRequestHTTP *request,
 
 	gdav_request_headers_add_depth (message, depth);
 
-	doc = xmlNewDoc (BAD_CAST "1.0");
-	root = xmlNewDocNode (doc, NULL, XC_PROPFIND, NULL);
-	xmlDocSetRootElement (doc, root);
-
-	namespaces = gdav_namespaces_ht_new (root);
-	nsdav = g_hash_table_lookup (namespaces, GDAV_XMLNS_DAV);
-	xmlSetNs (root, nsdav);
-
-	switch (type) {
-		case GDAV_PROPFIND_PROP:
-			gdav_namespaces_ht_collect (
-				namespaces, GDAV_PARSABLE (prop), root);
-			gdav_property_set_set_names_only (prop, TRUE);
-			success = gdav_parsable_serialize (
-				GDAV_PARSABLE (prop),
-				namespaces, doc, root, error);
-			break;
-
-		case GDAV_PROPFIND_ALLPROP:
-			xmlNewTextChild (root, nsdav, XC_ALLPROP, NULL);
-			break;
+	if (type == GDAV_PROPFIND_PROP &&
+	    gdav_property_set_is_frozen (prop)) {
+		GBytes *bytes;
 
-		case GDAV_PROPFIND_PROPNAME:
-			xmlNewTextChild (root, nsdav, XC_PROPNAME, NULL);
-			break;
-
-		default:
-			g_warn_if_reached ();
+		bytes = gdav_propfind_body_ref_cached (prop);
+		gdav_request_set_body_bytes (message, bytes);
+		g_bytes_unref (bytes);
+	} else {
+		gdav_request_take_body (
+			message, gdav_propfind_body_new (type, prop));
 	}
 
-	if (success)
-		gdav_request_write_body (message, doc, root);
-
-	g_hash_table_destroy (namespaces);
-
-	xmlFreeDoc (doc);
-
 	g_object_unref (message);
 
-	return success;
+	return TRUE;
 }
 
 SoupRequestHTTP *
@@ -588,6 +1042,7 @@ gdav_init_copy_request (SoupRequestHTTP *request,
 	message = soup_request_http_get_message (request);
 
 	gdav_request_headers_add_destination (message, destination);
+	gdav_request_invalidate_cache (request, destination);
 
 	if (flags & GDAV_COPY_FLAGS_NO_OVERWRITE)
 		gdav_request_headers_add_overwrite (message, FALSE);
@@ -654,6 +1109,7 @@ gdav_init_move_request (SoupRequestHTTP *request,
 	message = soup_request_http_get_message (request);
 
 	gdav_request_headers_add_destination (message, destination);
+	gdav_request_invalidate_cache (request, destination);
 
 	if (flags & GDAV_MOVE_FLAGS_NO_OVERWRITE)
 		gdav_request_headers_add_overwrite (message, FALSE);
@@ -715,11 +1171,8 @@ gdav_init_lock_request (SoupRequestHTTP *request,
                         GError **error)
 {
 	SoupMessage *message;
-	xmlDoc *doc;
-	xmlNode *root;   /* depth=0 */
-	xmlNode *node1;  /* depth=1 */
-	xmlNs *nsdav;
-	gboolean success;
+	GString *body;
+	const gchar *dav_prefix;
 
 	gdav_init_basic_request (request);
 
@@ -730,29 +1183,44 @@ gdav_init_lock_request (SoupRequestHTTP *request,
 	if (flags & GDAV_LOCK_FLAGS_NON_RECURSIVE)
 		gdav_request_headers_add_depth (message, GDAV_DEPTH_0);
 
-	doc = xmlNewDoc (BAD_CAST "1.0");
-	root = xmlNewDocNode (doc, NULL, XC_LOCKINFO, NULL);
-	xmlDocSetRootElement (doc, root);
+	dav_prefix = gdav_get_xmlns_prefix (GDAV_XMLNS_DAV);
+	g_warn_if_fail (dav_prefix != NULL);
 
-	nsdav = gdav_nsdav_new (root);
-	xmlSetNs (root, nsdav);
+	body = g_string_sized_new (256);
+
+	g_string_append_printf (
+		body, "<%s:%s", dav_prefix, (gchar *) XC_LOCKINFO);
+	gdav_xml_body_append_xmlns (body, GDAV_XMLNS_DAV, dav_prefix);
+	g_string_append_c (body, '>');
 
-	node1 = xmlNewTextChild (root, nsdav, XC_LOCKSCOPE, NULL);
+	gdav_xml_body_start_element (
+		body, dav_prefix, (gchar *) XC_LOCKSCOPE);
 
 	switch (lock_scope) {
 		case GDAV_LOCK_SCOPE_EXCLUSIVE:
 		default:  /* fallback for invalid values */
-			xmlNewTextChild (node1, nsdav, XC_EXCLUSIVE, NULL);
+			gdav_xml_body_append_element (
+				body, dav_prefix,
+				(gchar *) XC_EXCLUSIVE, NULL);
 			break;
 		case GDAV_LOCK_SCOPE_SHARED:
-			xmlNewTextChild (node1, nsdav, XC_SHARED, NULL);
+			gdav_xml_body_append_element (
+				body, dav_prefix,
+				(gchar *) XC_SHARED, NULL);
 			break;
 	}
 
+	gdav_xml_body_end_element (
+		body, dav_prefix, (gchar *) XC_LOCKSCOPE);
+
 	/* XXX Just hard-code this since there's only one valid locktype.
 	 *     We can rewrite it if GDavLockType ever grows new values. */
-	node1 = xmlNewTextChild (root, nsdav, XC_LOCKTYPE, NULL);
-	xmlNewTextChild (node1, nsdav, XC_WRITE, NULL);
+	gdav_xml_body_start_element (
+		body, dav_prefix, (gchar *) XC_LOCKTYPE);
+	gdav_xml_body_append_element (
+		body, dav_prefix, (gchar *) XC_WRITE, NULL);
+	gdav_xml_body_end_element (
+		body, dav_prefix, (gchar *) XC_LOCKTYPE);
 
 	if (owner != NULL) {
 		SoupURI *uri = NULL;
@@ -761,21 +1229,29 @@ gdav_init_lock_request (SoupRequestHTTP *request,
 			uri = soup_uri_new (owner);
 
 		if (uri != NULL) {
-			node1 = xmlNewTextChild (root, nsdav, XC_OWNER, NULL);
-			xmlNewTextChild (node1, nsdav, XC_HREF, owner);
+			gdav_xml_body_start_element (
+				body, dav_prefix, (gchar *) XC_OWNER);
+			gdav_xml_body_append_element (
+				body, dav_prefix,
+				(gchar *) XC_HREF, owner);
+			gdav_xml_body_end_element (
+				body, dav_prefix, (gchar *) XC_OWNER);
 			soup_uri_free (uri);
 		} else {
-			node1 = xmlNewTextChild (root, nsdav, XC_OWNER, owner);
+			gdav_xml_body_append_element (
+				body, dav_prefix,
+				(gchar *) XC_OWNER, owner);
 		}
 	}
 
-	gdav_request_write_body (message, doc, root);
+	gdav_xml_body_end_element (
+		body, dav_prefix, (gchar *) XC_LOCKINFO);
 
-	xmlFreeDoc (doc);
+	gdav_request_take_body (message, body);
 
 	g_object_unref (message);
 
-	return success;
+	return TRUE;
 }
 
 SoupRequestHTTP *
@@ -957,6 +1433,233 @@ gdav_request_unlock_uri (SoupSession *session,
 	return request;
 }
 
+static gboolean
+gdav_init_sync_collection_request (SoupRequestHTTP *request,
+                                   const gchar *sync_token,
+                                   GDavDepth sync_level,
+                                   GDavPropertySet *prop,
+                                   GError **error)
+{
+	SoupMessage *message;
+	GString *preamble;
+	GString *body;
+	const gchar *dav_prefix;
+
+	gdav_init_basic_request (request);
+
+	message = soup_request_http_get_message (request);
+
+	/* RFC 6578 Section 3.2: the report itself is Depth:0,
+	 * the scope of the sync goes in DAV:sync-level. */
+	gdav_request_headers_add_depth (message, GDAV_DEPTH_0);
+
+	dav_prefix = gdav_get_xmlns_prefix (GDAV_XMLNS_DAV);
+	g_warn_if_fail (dav_prefix != NULL);
+
+	/* An empty DAV:sync-token requests an initial sync. */
+	preamble = g_string_sized_new (128);
+	gdav_xml_body_append_element (
+		preamble, dav_prefix, (gchar *) XC_SYNC_TOKEN,
+		(sync_token != NULL) ? sync_token : "");
+	gdav_xml_body_append_element (
+		preamble, dav_prefix, (gchar *) XC_SYNC_LEVEL,
+		(sync_level == GDAV_DEPTH_INFINITY) ? "infinite" : "1");
+
+	body = g_string_sized_new (256);
+
+	if (prop != NULL) {
+		gdav_write_prop_body (
+			body, dav_prefix, GDAV_XMLNS_DAV,
+			(gchar *) XC_SYNC_COLLECTION,
+			preamble->str, prop);
+	} else {
+		/* DAV:prop is required even if empty. */
+		prop = gdav_property_set_new ();
+		gdav_write_prop_body (
+			body, dav_prefix, GDAV_XMLNS_DAV,
+			(gchar *) XC_SYNC_COLLECTION,
+			preamble->str, prop);
+		g_object_unref (prop);
+	}
+
+	gdav_xml_body_end_element (
+		body, dav_prefix, (gchar *) XC_SYNC_COLLECTION);
+
+	gdav_request_take_body (message, body);
+
+	g_string_free (preamble, TRUE);
+
+	g_object_unref (message);
+
+	return TRUE;
+}
+
+SoupRequestHTTP *
+gdav_request_sync_collection (SoupSession *session,
+                              const gchar *uri_string,
+                              const gchar *sync_token,
+                              GDavDepth sync_level,
+                              GDavPropertySet *prop,
+                              GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri_string != NULL, NULL);
+	g_return_val_if_fail (sync_level != GDAV_DEPTH_0, NULL);
+	g_return_val_if_fail (
+		prop == NULL || GDAV_IS_PROPERTY_SET (prop), NULL);
+
+	request = soup_session_request_http (
+		session, GDAV_METHOD_REPORT, uri_string, error);
+
+	if (request != NULL) {
+		if (!gdav_init_sync_collection_request (
+			request, sync_token, sync_level, prop, error))
+			g_clear_object (&request);
+	}
+
+	return request;
+}
+
+SoupRequestHTTP *
+gdav_request_sync_collection_uri (SoupSession *session,
+                                  SoupURI *uri,
+                                  const gchar *sync_token,
+                                  GDavDepth sync_level,
+                                  GDavPropertySet *prop,
+                                  GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+	g_return_val_if_fail (sync_level != GDAV_DEPTH_0, NULL);
+	g_return_val_if_fail (
+		prop == NULL || GDAV_IS_PROPERTY_SET (prop), NULL);
+
+	request = soup_session_request_http_uri (
+		session, GDAV_METHOD_REPORT, uri, error);
+
+	if (request != NULL) {
+		if (!gdav_init_sync_collection_request (
+			request, sync_token, sync_level, prop, error))
+			g_clear_object (&request);
+	}
+
+	return request;
+}
+
+static gboolean
+gdav_init_calendar_multiget_request (SoupRequestHTTP *request,
+                                     GDavPropertySet *prop,
+                                     const gchar * const *hrefs,
+                                     GError **error)
+{
+	SoupMessage *message;
+	GString *body;
+	const gchar *dav_prefix;
+	const gchar *caldav_prefix;
+	guint ii;
+
+	gdav_init_basic_request (request);
+
+	message = soup_request_http_get_message (request);
+
+	gdav_request_headers_add_depth (message, GDAV_DEPTH_1);
+
+	dav_prefix = gdav_get_xmlns_prefix (GDAV_XMLNS_DAV);
+	g_warn_if_fail (dav_prefix != NULL);
+
+	caldav_prefix = gdav_get_xmlns_prefix (GDAV_XMLNS_CALDAV);
+	g_warn_if_fail (caldav_prefix != NULL);
+
+	body = g_string_sized_new (256);
+
+	if (prop != NULL) {
+		gdav_write_prop_body (
+			body, dav_prefix, GDAV_XMLNS_CALDAV,
+			(gchar *) XC_CALENDAR_MULTIGET, NULL, prop);
+	} else {
+		prop = gdav_property_set_new ();
+		gdav_property_set_add_type (
+			prop, GDAV_TYPE_GETETAG_PROPERTY);
+		gdav_property_set_add_type (
+			prop, GDAV_TYPE_CALENDAR_DATA_PROPERTY);
+		gdav_write_prop_body (
+			body, dav_prefix, GDAV_XMLNS_CALDAV,
+			(gchar *) XC_CALENDAR_MULTIGET, NULL, prop);
+		g_object_unref (prop);
+	}
+
+	for (ii = 0; hrefs[ii] != NULL; ii++)
+		gdav_xml_body_append_element (
+			body, dav_prefix, (gchar *) XC_HREF, hrefs[ii]);
+
+	gdav_xml_body_end_element (
+		body, caldav_prefix, (gchar *) XC_CALENDAR_MULTIGET);
+
+	gdav_request_take_body (message, body);
+
+	g_object_unref (message);
+
+	return TRUE;
+}
+
+SoupRequestHTTP *
+gdav_request_calendar_multiget (SoupSession *session,
+                                const gchar *uri_string,
+                                GDavPropertySet *prop,
+                                const gchar * const *hrefs,
+                                GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri_string != NULL, NULL);
+	g_return_val_if_fail (
+		prop == NULL || GDAV_IS_PROPERTY_SET (prop), NULL);
+	g_return_val_if_fail (hrefs != NULL, NULL);
+
+	request = soup_session_request_http (
+		session, GDAV_METHOD_REPORT, uri_string, error);
+
+	if (request != NULL) {
+		if (!gdav_init_calendar_multiget_request (
+			request, prop, hrefs, error))
+			g_clear_object (&request);
+	}
+
+	return request;
+}
+
+SoupRequestHTTP *
+gdav_request_calendar_multiget_uri (SoupSession *session,
+                                    SoupURI *uri,
+                                    GDavPropertySet *prop,
+                                    const gchar * const *hrefs,
+                                    GError **error)
+{
+	SoupRequestHTTP *request;
+
+	g_return_val_if_fail (SOUP_IS_SESSION (session), NULL);
+	g_return_val_if_fail (uri != NULL, NULL);
+	g_return_val_if_fail (
+		prop == NULL || GDAV_IS_PROPERTY_SET (prop), NULL);
+	g_return_val_if_fail (hrefs != NULL, NULL);
+
+	request = soup_session_request_http_uri (
+		session, GDAV_METHOD_REPORT, uri, error);
+
+	if (request != NULL) {
+		if (!gdav_init_calendar_multiget_request (
+			request, prop, hrefs, error))
+			g_clear_object (&request);
+	}
+
+	return request;
+}
+
 void
 gdav_request_add_lock_token (SoupRequestHTTP *request,
                              const gchar *resource_tag,
@@ -35,6 +35,32 @@ SoupRequestHTTP *
 						 SoupURI *uri,
 						 GError **error);
 
+SoupRequestHTTP *
+		gdav_request_get		(SoupSession *session,
+						 const gchar *uri_string,
+						 GError **error);
+SoupRequestHTTP *
+		gdav_request_get_uri		(SoupSession *session,
+						 SoupURI *uri,
+						 GError **error);
+
+SoupRequestHTTP *
+		gdav_request_put		(SoupSession *session,
+						 const gchar *uri_string,
+						 goffset content_length,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags,
+						 GError **error);
+SoupRequestHTTP *
+		gdav_request_put_uri		(SoupSession *session,
+						 SoupURI *uri,
+						 goffset content_length,
+						 const gchar *content_type,
+						 const gchar *if_match,
+						 GDavPutFlags flags,
+						 GError **error);
+
 SoupRequestHTTP *
 		gdav_request_propfind		(SoupSession *session,
 						 const gchar *uri_string,
@@ -148,6 +174,36 @@ SoupRequestHTTP *
 						 const gchar *lock_token,
 						 GError **error);
 
+SoupRequestHTTP *
+		gdav_request_sync_collection	(SoupSession *session,
+						 const gchar *uri_string,
+						 const gchar *sync_token,
+						 GDavDepth sync_level,
+						 GDavPropertySet *prop,
+						 GError **error);
+SoupRequestHTTP *
+		gdav_request_sync_collection_uri
+						(SoupSession *session,
+						 SoupURI *uri,
+						 const gchar *sync_token,
+						 GDavDepth sync_level,
+						 GDavPropertySet *prop,
+						 GError **error);
+
+SoupRequestHTTP *
+		gdav_request_calendar_multiget	(SoupSession *session,
+						 const gchar *uri_string,
+						 GDavPropertySet *prop,
+						 const gchar * const *hrefs,
+						 GError **error);
+SoupRequestHTTP *
+		gdav_request_calendar_multiget_uri
+						(SoupSession *session,
+						 SoupURI *uri,
+						 GDavPropertySet *prop,
+						 const gchar * const *hrefs,
+						 GError **error);
+
 void		gdav_request_add_lock_token	(SoupRequestHTTP *request,
 						 const gchar *resource_tag,
 						 const gchar *lock_token);
@@ -23,10 +23,14 @@
 
 #include <glib/gi18n-lib.h>
 
+#include "gdav-xml-tokens.h"
+
 #define GDAV_RESPONSE_GET_PRIVATE(obj) \
 	(G_TYPE_INSTANCE_GET_PRIVATE \
 	((obj), GDAV_TYPE_RESPONSE, GDavResponsePrivate))
 
+typedef struct _PropertyIndexEntry PropertyIndexEntry;
+
 struct _GDavResponsePrivate {
 	GPtrArray *hrefs;
 	GPtrArray *propstats;
@@ -35,6 +39,18 @@ struct _GDavResponsePrivate {
 	gchar *location;
 	gchar *reason_phrase;
 	guint status_code;
+
+	/* Maps property GTypes to PropertyIndexEntry,
+	 * filled in as property types are looked up.  The
+	 * lock lets a response shared through a GDavCache
+	 * be read from several threads at once. */
+	GHashTable *property_index;
+	GMutex property_lock;
+};
+
+struct _PropertyIndexEntry {
+	GDavPropStat *propstat;		/* NULL if not present */
+	GDavProperty *property;		/* NULL unless status is OK */
 };
 
 enum {
@@ -93,6 +109,11 @@ gdav_response_dispose (GObject *object)
 
 	priv = GDAV_RESPONSE_GET_PRIVATE (object);
 
+	if (priv->property_index != NULL) {
+		g_hash_table_destroy (priv->property_index);
+		priv->property_index = NULL;
+	}
+
 	g_ptr_array_set_size (priv->hrefs, 0);
 	g_ptr_array_set_size (priv->propstats, 0);
 	g_clear_object (&priv->error);
@@ -115,12 +136,82 @@ gdav_response_finalize (GObject *object)
 	g_free (priv->location);
 	g_free (priv->reason_phrase);
 
+	g_mutex_clear (&priv->property_lock);
+
 	/* Chain up to parent's finalize() method. */
 	G_OBJECT_CLASS (gdav_response_parent_class)->finalize (object);
 }
 
+static void
+property_index_entry_free (PropertyIndexEntry *entry)
+{
+	g_slice_free (PropertyIndexEntry, entry);
+}
+
+static PropertyIndexEntry *
+gdav_response_lookup_property (GDavResponse *response,
+                               GType property_type)
+{
+	GDavResponsePrivate *priv;
+	PropertyIndexEntry *entry;
+	guint ii;
+
+	priv = response->priv;
+
+	/* Entries are never freed once the response is parsed,
+	 * so it's safe to hand one out after unlocking. */
+	g_mutex_lock (&priv->property_lock);
+
+	if (priv->property_index == NULL) {
+		priv->property_index = g_hash_table_new_full (
+			NULL, NULL, NULL,
+			(GDestroyNotify) property_index_entry_free);
+	}
+
+	entry = g_hash_table_lookup (
+		priv->property_index,
+		GSIZE_TO_POINTER (property_type));
+
+	if (entry != NULL) {
+		g_mutex_unlock (&priv->property_lock);
+		return entry;
+	}
+
+	entry = g_slice_new0 (PropertyIndexEntry);
+
+	for (ii = 0; ii < priv->propstats->len; ii++) {
+		GDavPropStat *propstat;
+		GDavPropertySet *prop;
+
+		propstat = priv->propstats->pdata[ii];
+		prop = gdav_prop_stat_get_prop (propstat);
+
+		if (!gdav_property_set_has_type (prop, property_type))
+			continue;
+
+		entry->propstat = propstat;
+
+		if (gdav_prop_stat_get_status (propstat, NULL) ==
+		    SOUP_STATUS_OK)
+			entry->property = gdav_property_set_peek (
+				prop, property_type);
+
+		break;
+	}
+
+	/* Misses are recorded too, so they stay cheap. */
+	g_hash_table_insert (
+		priv->property_index,
+		GSIZE_TO_POINTER (property_type), entry);
+
+	g_mutex_unlock (&priv->property_lock);
+
+	return entry;
+}
+
 static gboolean
 gdav_response_deserialize_dav (GDavParsable *parsable,
+                               GDavXmlToken token,
                                SoupURI *base_uri,
                                xmlDoc *doc,
                                xmlNode *node,
@@ -132,7 +223,7 @@ gdav_response_deserialize_dav (GDavParsable *parsable,
 
 	/* Handle nodes in the GDAV_XMLNS_DAV namespace. */
 
-	if (xmlStrcmp (node->name, BAD_CAST "href") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_HREF) {
 		xmlChar *text;
 		SoupURI *uri;
 		gboolean success;
@@ -159,7 +250,7 @@ gdav_response_deserialize_dav (GDavParsable *parsable,
 		return success;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "status") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_STATUS) {
 		xmlChar *text;
 		gboolean success;
 
@@ -186,7 +277,7 @@ gdav_response_deserialize_dav (GDavParsable *parsable,
 		return success;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "propstat") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_PROPSTAT) {
 		GDavParsable *item;
 
 		item = gdav_parsable_new_from_xml_node (
@@ -196,10 +287,14 @@ gdav_response_deserialize_dav (GDavParsable *parsable,
 
 		g_ptr_array_add (priv->propstats, item);
 
+		/* Discard lookups made without this propstat. */
+		if (priv->property_index != NULL)
+			g_hash_table_remove_all (priv->property_index);
+
 		return TRUE;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "error") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_ERROR) {
 		GDavParsable *item;
 
 		item = gdav_parsable_new_from_xml_node (
@@ -213,7 +308,7 @@ gdav_response_deserialize_dav (GDavParsable *parsable,
 		return TRUE;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "responsedescription") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_RESPONSEDESCRIPTION) {
 		xmlChar *text;
 
 		text = xmlNodeListGetString (doc, node->children, TRUE);
@@ -224,7 +319,7 @@ gdav_response_deserialize_dav (GDavParsable *parsable,
 		return TRUE;
 	}
 
-	if (xmlStrcmp (node->name, BAD_CAST "location") == 0) {
+	if (token == GDAV_XML_TOKEN_DAV_LOCATION) {
 		xmlChar *text;
 
 		text = xmlNodeListGetString (doc, node->children, TRUE);
@@ -247,9 +342,13 @@ gdav_response_deserialize (GDavParsable *parsable,
                            xmlNode *node,
                            GError **error)
 {
-	if (gdav_is_xmlns (node, GDAV_XMLNS_DAV)) {
+	GDavXmlToken token;
+
+	token = gdav_xml_node_get_token (node);
+
+	if (token != GDAV_XML_TOKEN_OTHER) {
 		return gdav_response_deserialize_dav (
-			parsable, base_uri, doc, node, error);
+			parsable, token, base_uri, doc, node, error);
 	}
 
 	/* Chain up to parent's deserialize() method. */
@@ -302,6 +401,8 @@ gdav_response_init (GDavResponse *response)
 {
 	response->priv = GDAV_RESPONSE_GET_PRIVATE (response);
 
+	g_mutex_init (&response->priv->property_lock);
+
 	response->priv->hrefs =
 		g_ptr_array_new_with_free_func (
 		(GDestroyNotify) soup_uri_free);
@@ -328,6 +429,28 @@ gdav_response_has_href (GDavResponse *response,
 	return FALSE;
 }
 
+SoupURI *
+gdav_response_get_href (GDavResponse *response,
+                        guint index)
+{
+	SoupURI *uri = NULL;
+
+	g_return_val_if_fail (GDAV_IS_RESPONSE (response), NULL);
+
+	if (index < response->priv->hrefs->len)
+		uri = response->priv->hrefs->pdata[index];
+
+	return uri;
+}
+
+guint
+gdav_response_get_n_hrefs (GDavResponse *response)
+{
+	g_return_val_if_fail (GDAV_IS_RESPONSE (response), 0);
+
+	return response->priv->hrefs->len;
+}
+
 guint
 gdav_response_get_status (GDavResponse *response,
                           gchar **reason_phrase)
@@ -392,7 +515,8 @@ gdav_response_find_property (GDavResponse *response,
                              GValue *value,
                              gchar **reason_phrase)
 {
-	guint ii, n_propstats;
+	PropertyIndexEntry *entry;
+	guint status;
 
 	g_return_val_if_fail (
 		GDAV_IS_RESPONSE (response), SOUP_STATUS_NONE);
@@ -400,33 +524,57 @@ gdav_response_find_property (GDavResponse *response,
 		g_type_is_a (property_type, GDAV_TYPE_PROPERTY),
 		SOUP_STATUS_NONE);
 
-	n_propstats = gdav_response_get_n_propstats (response);
+	entry = gdav_response_lookup_property (response, property_type);
 
-	for (ii = 0; ii < n_propstats; ii++) {
-		GDavPropStat *propstat;
-		GDavPropertySet *prop;
-		GList *list = NULL;
-		guint status;
+	if (entry->propstat == NULL)
+		return SOUP_STATUS_NONE;
 
-		propstat = gdav_response_get_propstat (response, ii);
-		prop = gdav_prop_stat_get_prop (propstat);
+	status = gdav_prop_stat_get_status (entry->propstat, reason_phrase);
 
-		if (!gdav_property_set_has_type (prop, property_type))
-			continue;
+	if (entry->property != NULL && value != NULL)
+		gdav_property_get_value (entry->property, value);
+
+	return status;
+}
 
-		status = gdav_prop_stat_get_status (propstat, reason_phrase);
+/**
+ * gdav_response_peek_property:
+ * @response: a #GDavResponse
+ * @property_type: a #GDavProperty subtype
+ * @out_status: return location for the property status, or %NULL
+ *
+ * Like gdav_response_find_property() but returns the property value
+ * without copying it.  Repeated lookups of the same property type
+ * are answered from an index and do not allocate.  This is safe to
+ * call from several threads on a shared response, such as one from
+ * gdav_cache_ref_multi_status().
+ *
+ * Returns: the property value owned by @response, or %NULL if the
+ *          property status is not %SOUP_STATUS_OK
+ **/
+const GValue *
+gdav_response_peek_property (GDavResponse *response,
+                             GType property_type,
+                             guint *out_status)
+{
+	PropertyIndexEntry *entry;
+	guint status = SOUP_STATUS_NONE;
 
-		if (status == SOUP_STATUS_OK && value != NULL)
-			list = gdav_property_set_list (prop, property_type);
+	g_return_val_if_fail (GDAV_IS_RESPONSE (response), NULL);
+	g_return_val_if_fail (
+		g_type_is_a (property_type, GDAV_TYPE_PROPERTY), NULL);
 
-		if (list != NULL)
-			gdav_property_get_value (list->data, value);
+	entry = gdav_response_lookup_property (response, property_type);
 
-		g_list_free_full (list, (GDestroyNotify) g_object_unref);
+	if (entry->propstat != NULL)
+		status = gdav_prop_stat_get_status (entry->propstat, NULL);
 
-		return status;
-	}
+	if (out_status != NULL)
+		*out_status = status;
+
+	if (entry->property == NULL)
+		return NULL;
 
-	return SOUP_STATUS_NONE;
+	return gdav_property_peek_value (entry->property);
 }
 
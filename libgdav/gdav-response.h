@@ -61,6 +61,9 @@ struct _GDavResponseClass {
 GType		gdav_response_get_type		(void) G_GNUC_CONST;
 gboolean	gdav_response_has_href		(GDavResponse *response,
 						 SoupURI *uri);
+SoupURI *	gdav_response_get_href		(GDavResponse *response,
+						 guint index);
+guint		gdav_response_get_n_hrefs	(GDavResponse *response);
 guint		gdav_response_get_status	(GDavResponse *response,
 						 gchar **reason_phrase);
 GDavPropStat *	gdav_response_get_propstat	(GDavResponse *response,
@@ -74,6 +77,9 @@ guint		gdav_response_find_property	(GDavResponse *response,
 						 GType property_type,
 						 GValue *value,
 						 gchar **reason_phrase);
+const GValue *	gdav_response_peek_property	(GDavResponse *response,
+						 GType property_type,
+						 guint *out_status);
 
 G_END_DECLS
 
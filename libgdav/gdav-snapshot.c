@@ -0,0 +1,681 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "gdav-snapshot.h"
+
+#include <glib/gi18n-lib.h>
+
+#include "gdav-utils-private.h"
+
+#define GDAV_SNAPSHOT_GET_PRIVATE(obj) \
+	(G_TYPE_INSTANCE_GET_PRIVATE \
+	((obj), GDAV_TYPE_SNAPSHOT, GDavSnapshotPrivate))
+
+/* The file is a header, an array of fixed-size records sorted by
+ * href, and a table of nul-terminated strings the records refer to
+ * by offset.  Hrefs are ordered by gdav_href_compare(), so a trailing
+ * slash makes no difference.  Everything is in host byte order; the
+ * byte_order field just lets a file from a different architecture be
+ * rejected.  Only the header is checked when loading, plus a pass over
+ * the records to make sure no string offset points outside the file. */
+
+#define SNAPSHOT_MAGIC		"GDAVSNAP"
+#define SNAPSHOT_VERSION	2
+#define SNAPSHOT_BYTE_ORDER	0x01020304
+
+/* String offset meaning NULL. */
+#define NO_STRING		G_MAXUINT32
+
+typedef struct _SnapshotHeader SnapshotHeader;
+typedef struct _SnapshotRecord SnapshotRecord;
+
+struct _SnapshotHeader {
+	gchar magic[8];
+	guint32 version;
+	guint32 byte_order;
+	guint32 n_records;
+	guint32 sync_token;
+	guint64 records_offset;
+	guint64 strings_offset;
+	guint64 strings_size;
+};
+
+struct _SnapshotRecord {
+	guint32 href;
+	guint32 etag;
+	guint64 content_length;
+	gint64 last_modified;
+	guint32 resource_type;
+	guint32 status;
+};
+
+G_STATIC_ASSERT (sizeof (SnapshotHeader) == 48);
+G_STATIC_ASSERT (sizeof (SnapshotRecord) == 32);
+
+struct _GDavSnapshotPrivate {
+	/* One or the other holds the data. */
+	GMappedFile *mapped_file;
+	GBytes *bytes;
+
+	const gchar *data;
+	gsize size;
+
+	const SnapshotHeader *header;
+	const SnapshotRecord *records;
+	const gchar *strings;
+};
+
+G_DEFINE_TYPE (GDavSnapshot, gdav_snapshot, G_TYPE_OBJECT)
+
+static const gchar *
+gdav_snapshot_string (GDavSnapshot *snapshot,
+                      guint32 offset)
+{
+	if (offset == NO_STRING)
+		return NULL;
+
+	return snapshot->priv->strings + offset;
+}
+
+static guint32
+gdav_snapshot_add_string (GByteArray *strings,
+                          const gchar *string)
+{
+	guint32 offset;
+
+	if (string == NULL)
+		return NO_STRING;
+
+	offset = strings->len;
+	g_byte_array_append (
+		strings, (const guint8 *) string, strlen (string) + 1);
+
+	return offset;
+}
+
+static gboolean
+gdav_snapshot_set_data (GDavSnapshot *snapshot,
+                        const gchar *data,
+                        gsize size)
+{
+	const SnapshotHeader *header;
+	const SnapshotRecord *records;
+	guint32 ii;
+
+	header = (const SnapshotHeader *) data;
+
+	if (data == NULL || size < sizeof (SnapshotHeader))
+		return FALSE;
+
+	if (memcmp (header->magic, SNAPSHOT_MAGIC, 8) != 0 ||
+	    header->version != SNAPSHOT_VERSION ||
+	    header->byte_order != SNAPSHOT_BYTE_ORDER)
+		return FALSE;
+
+	/* Records must be aligned and inside the file. */
+	if (header->records_offset % 8 != 0 ||
+	    header->records_offset < sizeof (SnapshotHeader) ||
+	    header->records_offset > size ||
+	    header->n_records >
+	    (size - header->records_offset) / sizeof (SnapshotRecord))
+		return FALSE;
+
+	/* Strings must be inside the file and nul-terminated. */
+	if (header->strings_offset > size ||
+	    header->strings_size == 0 ||
+	    header->strings_size > size - header->strings_offset ||
+	    data[header->strings_offset + header->strings_size - 1] != '\0')
+		return FALSE;
+
+	if (header->sync_token != NO_STRING &&
+	    header->sync_token >= header->strings_size)
+		return FALSE;
+
+	records = (const SnapshotRecord *)
+		(data + header->records_offset);
+
+	for (ii = 0; ii < header->n_records; ii++) {
+		if (records[ii].href >= header->strings_size)
+			return FALSE;
+		if (records[ii].etag != NO_STRING &&
+		    records[ii].etag >= header->strings_size)
+			return FALSE;
+	}
+
+	snapshot->priv->data = data;
+	snapshot->priv->size = size;
+	snapshot->priv->header = header;
+	snapshot->priv->records = records;
+	snapshot->priv->strings = data + header->strings_offset;
+
+	return TRUE;
+}
+
+static gint
+gdav_snapshot_compare_rows (gconstpointer a,
+                            gconstpointer b,
+                            gpointer user_data)
+{
+	const gchar * const *hrefs = user_data;
+
+	return gdav_href_compare (
+		hrefs[*(const guint *) a], hrefs[*(const guint *) b]);
+}
+
+/* Returns the listing's row numbers sorted by href,
+ * leaving out rows that repeat an earlier href. */
+static GArray *
+gdav_snapshot_sort_listing (GDavListing *listing)
+{
+	const gchar * const *hrefs;
+	GArray *rows;
+	guint ii, jj, length;
+
+	length = gdav_listing_get_length (listing);
+	hrefs = gdav_listing_peek_hrefs (listing);
+
+	rows = g_array_sized_new (FALSE, FALSE, sizeof (guint), length);
+
+	for (ii = 0; ii < length; ii++) {
+		if (hrefs[ii] != NULL)
+			g_array_append_val (rows, ii);
+	}
+
+	g_qsort_with_data (
+		rows->data, rows->len, sizeof (guint),
+		gdav_snapshot_compare_rows, (gpointer) hrefs);
+
+	for (ii = 1, jj = 1; ii < rows->len; ii++) {
+		guint prev = g_array_index (rows, guint, jj - 1);
+		guint this = g_array_index (rows, guint, ii);
+
+		if (!gdav_href_equal (hrefs[prev], hrefs[this]))
+			g_array_index (rows, guint, jj++) = this;
+	}
+
+	if (rows->len > 0)
+		g_array_set_size (rows, jj);
+
+	return rows;
+}
+
+static gboolean
+gdav_snapshot_record_modified (GDavSnapshot *snapshot,
+                               const SnapshotRecord *record,
+                               GDavListing *listing,
+                               guint row)
+{
+	GDavResourceState old_state;
+	GDavResourceState new_state;
+
+	old_state.resource_type = record->resource_type;
+	old_state.etag = gdav_snapshot_string (snapshot, record->etag);
+	old_state.content_length = record->content_length;
+	old_state.last_modified = record->last_modified;
+
+	new_state.resource_type =
+		gdav_listing_get_resource_type (listing, row);
+	new_state.etag = gdav_listing_get_etag (listing, row);
+	new_state.content_length =
+		gdav_listing_get_content_length (listing, row);
+	new_state.last_modified =
+		gdav_listing_get_last_modified (listing, row);
+
+	return gdav_resource_state_changed (&old_state, &new_state);
+}
+
+static void
+gdav_snapshot_finalize (GObject *object)
+{
+	GDavSnapshotPrivate *priv;
+
+	priv = GDAV_SNAPSHOT_GET_PRIVATE (object);
+
+	if (priv->mapped_file != NULL)
+		g_mapped_file_unref (priv->mapped_file);
+
+	if (priv->bytes != NULL)
+		g_bytes_unref (priv->bytes);
+
+	/* Chain up to parent's finalize() method. */
+	G_OBJECT_CLASS (gdav_snapshot_parent_class)->finalize (object);
+}
+
+static void
+gdav_snapshot_class_init (GDavSnapshotClass *class)
+{
+	GObjectClass *object_class;
+
+	g_type_class_add_private (class, sizeof (GDavSnapshotPrivate));
+
+	object_class = G_OBJECT_CLASS (class);
+	object_class->finalize = gdav_snapshot_finalize;
+}
+
+static void
+gdav_snapshot_init (GDavSnapshot *snapshot)
+{
+	snapshot->priv = GDAV_SNAPSHOT_GET_PRIVATE (snapshot);
+}
+
+/**
+ * gdav_snapshot_new_from_listing:
+ * @listing: a #GDavListing
+ * @sync_token: the collection's DAV:sync-token, or %NULL
+ *
+ * Creates a #GDavSnapshot of the rows in @listing, typically the
+ * result of a Depth:1 PROPFIND for a collection, along with the
+ * collection's @sync_token for the next sync-collection report.
+ * Rows without an href are left out, as are repeated hrefs.
+ *
+ * Returns: a new #GDavSnapshot
+ **/
+GDavSnapshot *
+gdav_snapshot_new_from_listing (GDavListing *listing,
+                                const gchar *sync_token)
+{
+	GDavSnapshot *snapshot;
+	SnapshotHeader header;
+	SnapshotRecord *records;
+	GByteArray *strings;
+	GByteArray *data;
+	GArray *rows;
+	guint ii;
+
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), NULL);
+
+	rows = gdav_snapshot_sort_listing (listing);
+
+	records = g_new0 (SnapshotRecord, rows->len);
+	strings = g_byte_array_new ();
+
+	for (ii = 0; ii < rows->len; ii++) {
+		guint row = g_array_index (rows, guint, ii);
+
+		records[ii].href = gdav_snapshot_add_string (
+			strings, gdav_listing_get_href (listing, row));
+		records[ii].etag = gdav_snapshot_add_string (
+			strings, gdav_listing_get_etag (listing, row));
+		records[ii].content_length =
+			gdav_listing_get_content_length (listing, row);
+		records[ii].last_modified =
+			gdav_listing_get_last_modified (listing, row);
+		records[ii].resource_type =
+			gdav_listing_get_resource_type (listing, row);
+		records[ii].status =
+			gdav_listing_get_status (listing, row);
+	}
+
+	memset (&header, 0, sizeof (SnapshotHeader));
+	memcpy (header.magic, SNAPSHOT_MAGIC, 8);
+	header.version = SNAPSHOT_VERSION;
+	header.byte_order = SNAPSHOT_BYTE_ORDER;
+	header.n_records = rows->len;
+	header.sync_token = gdav_snapshot_add_string (strings, sync_token);
+
+	/* Make sure the string table is never empty. */
+	if (strings->len == 0)
+		gdav_snapshot_add_string (strings, "");
+
+	header.records_offset = sizeof (SnapshotHeader);
+	header.strings_offset =
+		header.records_offset +
+		(guint64) rows->len * sizeof (SnapshotRecord);
+	header.strings_size = strings->len;
+
+	data = g_byte_array_sized_new (
+		header.strings_offset + header.strings_size);
+	g_byte_array_append (
+		data, (const guint8 *) &header, sizeof (SnapshotHeader));
+	g_byte_array_append (
+		data, (const guint8 *) records,
+		rows->len * sizeof (SnapshotRecord));
+	g_byte_array_append (data, strings->data, strings->len);
+
+	snapshot = g_object_new (GDAV_TYPE_SNAPSHOT, NULL);
+	snapshot->priv->bytes = g_byte_array_free_to_bytes (data);
+
+	/* Can't fail, but this sets up the pointers. */
+	gdav_snapshot_set_data (
+		snapshot,
+		g_bytes_get_data (snapshot->priv->bytes, NULL),
+		g_bytes_get_size (snapshot->priv->bytes));
+
+	g_byte_array_unref (strings);
+	g_array_free (rows, TRUE);
+	g_free (records);
+
+	return snapshot;
+}
+
+/**
+ * gdav_snapshot_new_from_file:
+ * @filename: a file written by gdav_snapshot_save()
+ * @error: return location for a #GError, or %NULL
+ *
+ * Loads a #GDavSnapshot from @filename.  The file is memory-mapped
+ * rather than read, so loading takes about the same time regardless
+ * of the number of rows, and pages are only read in as rows are used.
+ * The file should not be modified while the snapshot is in use;
+ * gdav_snapshot_save() replaces files rather than rewriting them.
+ *
+ * Returns: a new #GDavSnapshot, or %NULL on error
+ **/
+GDavSnapshot *
+gdav_snapshot_new_from_file (const gchar *filename,
+                             GError **error)
+{
+	GDavSnapshot *snapshot;
+	GMappedFile *mapped_file;
+
+	g_return_val_if_fail (filename != NULL, NULL);
+
+	mapped_file = g_mapped_file_new (filename, FALSE, error);
+
+	if (mapped_file == NULL)
+		return NULL;
+
+	snapshot = g_object_new (GDAV_TYPE_SNAPSHOT, NULL);
+	snapshot->priv->mapped_file = mapped_file;
+
+	if (!gdav_snapshot_set_data (
+		snapshot,
+		g_mapped_file_get_contents (mapped_file),
+		g_mapped_file_get_length (mapped_file))) {
+		g_set_error (
+			error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+			_("'%s' is not a valid snapshot file"), filename);
+		g_object_unref (snapshot);
+		snapshot = NULL;
+	}
+
+	return snapshot;
+}
+
+/**
+ * gdav_snapshot_save:
+ * @snapshot: a #GDavSnapshot
+ * @filename: the file to write
+ * @error: return location for a #GError, or %NULL
+ *
+ * Writes @snapshot to @filename for gdav_snapshot_new_from_file().
+ * The file is replaced atomically, so a snapshot mapped from it
+ * stays intact.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ **/
+gboolean
+gdav_snapshot_save (GDavSnapshot *snapshot,
+                    const gchar *filename,
+                    GError **error)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	return g_file_set_contents (
+		filename, snapshot->priv->data,
+		snapshot->priv->size, error);
+}
+
+guint
+gdav_snapshot_get_length (GDavSnapshot *snapshot)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), 0);
+
+	return snapshot->priv->header->n_records;
+}
+
+/**
+ * gdav_snapshot_get_sync_token:
+ * @snapshot: a #GDavSnapshot
+ *
+ * Returns: the DAV:sync-token given when @snapshot was created,
+ *          or %NULL
+ **/
+const gchar *
+gdav_snapshot_get_sync_token (GDavSnapshot *snapshot)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), NULL);
+
+	return gdav_snapshot_string (
+		snapshot, snapshot->priv->header->sync_token);
+}
+
+/**
+ * gdav_snapshot_lookup:
+ * @snapshot: a #GDavSnapshot
+ * @href: an href to look for
+ * @out_index: return location for the row number, or %NULL
+ *
+ * Looks up the row for @href with a binary search.  A trailing slash
+ * is ignored when matching.
+ *
+ * Returns: %TRUE if @href was found
+ **/
+gboolean
+gdav_snapshot_lookup (GDavSnapshot *snapshot,
+                      const gchar *href,
+                      guint *out_index)
+{
+	guint lower, upper;
+
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), FALSE);
+	g_return_val_if_fail (href != NULL, FALSE);
+
+	lower = 0;
+	upper = snapshot->priv->header->n_records;
+
+	while (lower < upper) {
+		guint middle = lower + (upper - lower) / 2;
+		gint cmp;
+
+		cmp = gdav_href_compare (href, gdav_snapshot_string (
+			snapshot, snapshot->priv->records[middle].href));
+
+		if (cmp == 0) {
+			if (out_index != NULL)
+				*out_index = middle;
+			return TRUE;
+		}
+
+		if (cmp < 0)
+			upper = middle;
+		else
+			lower = middle + 1;
+	}
+
+	return FALSE;
+}
+
+const gchar *
+gdav_snapshot_get_href (GDavSnapshot *snapshot,
+                        guint index)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), NULL);
+	g_return_val_if_fail (
+		index < snapshot->priv->header->n_records, NULL);
+
+	return gdav_snapshot_string (
+		snapshot, snapshot->priv->records[index].href);
+}
+
+guint
+gdav_snapshot_get_status (GDavSnapshot *snapshot,
+                          guint index)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), 0);
+	g_return_val_if_fail (
+		index < snapshot->priv->header->n_records, 0);
+
+	return snapshot->priv->records[index].status;
+}
+
+const gchar *
+gdav_snapshot_get_etag (GDavSnapshot *snapshot,
+                        guint index)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), NULL);
+	g_return_val_if_fail (
+		index < snapshot->priv->header->n_records, NULL);
+
+	return gdav_snapshot_string (
+		snapshot, snapshot->priv->records[index].etag);
+}
+
+guint64
+gdav_snapshot_get_content_length (GDavSnapshot *snapshot,
+                                  guint index)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), 0);
+	g_return_val_if_fail (
+		index < snapshot->priv->header->n_records, 0);
+
+	return snapshot->priv->records[index].content_length;
+}
+
+/**
+ * gdav_snapshot_get_last_modified:
+ * @snapshot: a #GDavSnapshot
+ * @index: a row number
+ *
+ * Returns: the DAV:getlastmodified time for row @index as a
+ *          Unix timestamp, or 0 if not known
+ **/
+gint64
+gdav_snapshot_get_last_modified (GDavSnapshot *snapshot,
+                                 guint index)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), 0);
+	g_return_val_if_fail (
+		index < snapshot->priv->header->n_records, 0);
+
+	return snapshot->priv->records[index].last_modified;
+}
+
+GDavResourceType
+gdav_snapshot_get_resource_type (GDavSnapshot *snapshot,
+                                 guint index)
+{
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), 0);
+	g_return_val_if_fail (
+		index < snapshot->priv->header->n_records, 0);
+
+	return snapshot->priv->records[index].resource_type;
+}
+
+/**
+ * gdav_snapshot_diff:
+ * @snapshot: a #GDavSnapshot
+ * @listing: a #GDavListing
+ * @func: a #GDavSnapshotDiffFunc, or %NULL
+ * @user_data: data to pass to @func
+ *
+ * Compares a fresh @listing of a collection against @snapshot, calling
+ * @func for each href that was added, removed or modified, in href
+ * order.  A resource counts as modified if its resource type or entity
+ * tag changed, or, when neither side has an entity tag, if its size or
+ * modification time changed.
+ *
+ * If @func is %NULL, this just checks for differences.
+ *
+ * Returns: %TRUE if there were any differences
+ **/
+gboolean
+gdav_snapshot_diff (GDavSnapshot *snapshot,
+                    GDavListing *listing,
+                    GDavSnapshotDiffFunc func,
+                    gpointer user_data)
+{
+	const SnapshotRecord *records;
+	const gchar * const *hrefs;
+	GArray *rows;
+	guint ii = 0, jj = 0, n_records;
+	gboolean changed = FALSE;
+
+	g_return_val_if_fail (GDAV_IS_SNAPSHOT (snapshot), FALSE);
+	g_return_val_if_fail (GDAV_IS_LISTING (listing), FALSE);
+
+	records = snapshot->priv->records;
+	n_records = snapshot->priv->header->n_records;
+
+	hrefs = gdav_listing_peek_hrefs (listing);
+
+	rows = gdav_snapshot_sort_listing (listing);
+
+	/* Both sides are sorted by href, so walk them together. */
+	while (ii < n_records || jj < rows->len) {
+		const SnapshotRecord *record = NULL;
+		GDavChange change;
+		gint snapshot_index = -1;
+		gint listing_index = -1;
+		gint cmp;
+
+		if (ii < n_records)
+			record = &records[ii];
+
+		if (jj < rows->len)
+			listing_index = g_array_index (rows, guint, jj);
+
+		if (record == NULL)
+			cmp = 1;
+		else if (listing_index < 0)
+			cmp = -1;
+		else
+			cmp = gdav_href_compare (
+				gdav_snapshot_string (snapshot, record->href),
+				hrefs[listing_index]);
+
+		if (cmp < 0) {
+			change = GDAV_CHANGE_REMOVED;
+			snapshot_index = ii++;
+			listing_index = -1;
+
+		} else if (cmp > 0) {
+			change = GDAV_CHANGE_ADDED;
+			jj++;
+
+		} else {
+			snapshot_index = ii++;
+			jj++;
+
+			if (!gdav_snapshot_record_modified (
+				snapshot, record, listing, listing_index))
+				continue;
+
+			change = GDAV_CHANGE_MODIFIED;
+		}
+
+		changed = TRUE;
+
+		if (func == NULL)
+			break;
+
+		if (!func (snapshot, listing, change,
+		    snapshot_index, listing_index, user_data))
+			break;
+	}
+
+	g_array_free (rows, TRUE);
+
+	return changed;
+}
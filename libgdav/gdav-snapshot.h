@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_SNAPSHOT_H__
+#define __GDAV_SNAPSHOT_H__
+
+#include <libgdav/gdav-listing.h>
+
+/* Standard GObject macros */
+#define GDAV_TYPE_SNAPSHOT \
+	(gdav_snapshot_get_type ())
+#define GDAV_SNAPSHOT(obj) \
+	(G_TYPE_CHECK_INSTANCE_CAST \
+	((obj), GDAV_TYPE_SNAPSHOT, GDavSnapshot))
+#define GDAV_SNAPSHOT_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_CAST \
+	((cls), GDAV_TYPE_SNAPSHOT, GDavSnapshotClass))
+#define GDAV_IS_SNAPSHOT(obj) \
+	(G_TYPE_CHECK_INSTANCE_TYPE \
+	((obj), GDAV_TYPE_SNAPSHOT))
+#define GDAV_IS_SNAPSHOT_CLASS(cls) \
+	(G_TYPE_CHECK_CLASS_TYPE \
+	((cls), GDAV_TYPE_SNAPSHOT))
+#define GDAV_SNAPSHOT_GET_CLASS(obj) \
+	(G_TYPE_INSTANCE_GET_CLASS \
+	((obj), GDAV_TYPE_SNAPSHOT, GDavSnapshotClass))
+
+G_BEGIN_DECLS
+
+typedef struct _GDavSnapshot GDavSnapshot;
+typedef struct _GDavSnapshotClass GDavSnapshotClass;
+typedef struct _GDavSnapshotPrivate GDavSnapshotPrivate;
+
+/**
+ * GDavSnapshotDiffFunc:
+ * @snapshot: a #GDavSnapshot
+ * @listing: a #GDavListing
+ * @change: how the resource changed
+ * @snapshot_index: the resource's row in @snapshot, or -1 if added
+ * @listing_index: the resource's row in @listing, or -1 if removed
+ * @user_data: user data passed to gdav_snapshot_diff()
+ *
+ * Called by gdav_snapshot_diff() for each resource that differs.
+ *
+ * Returns: %TRUE to continue, %FALSE to stop
+ **/
+typedef gboolean	(*GDavSnapshotDiffFunc)	(GDavSnapshot *snapshot,
+						 GDavListing *listing,
+						 GDavChange change,
+						 gint snapshot_index,
+						 gint listing_index,
+						 gpointer user_data);
+
+/**
+ * GDavSnapshot:
+ *
+ * An immutable record of a collection's members as of some point in
+ * time, in a compact binary form that can be saved to a file and
+ * memory-mapped back in without parsing.  Rows are sorted by href.
+ **/
+struct _GDavSnapshot {
+	GObject parent;
+	GDavSnapshotPrivate *priv;
+};
+
+struct _GDavSnapshotClass {
+	GObjectClass parent_class;
+};
+
+GType		gdav_snapshot_get_type		(void) G_GNUC_CONST;
+GDavSnapshot *	gdav_snapshot_new_from_listing	(GDavListing *listing,
+						 const gchar *sync_token);
+GDavSnapshot *	gdav_snapshot_new_from_file	(const gchar *filename,
+						 GError **error);
+gboolean	gdav_snapshot_save		(GDavSnapshot *snapshot,
+						 const gchar *filename,
+						 GError **error);
+guint		gdav_snapshot_get_length	(GDavSnapshot *snapshot);
+const gchar *	gdav_snapshot_get_sync_token	(GDavSnapshot *snapshot);
+gboolean	gdav_snapshot_lookup		(GDavSnapshot *snapshot,
+						 const gchar *href,
+						 guint *out_index);
+const gchar *	gdav_snapshot_get_href		(GDavSnapshot *snapshot,
+						 guint index);
+guint		gdav_snapshot_get_status	(GDavSnapshot *snapshot,
+						 guint index);
+const gchar *	gdav_snapshot_get_etag		(GDavSnapshot *snapshot,
+						 guint index);
+guint64		gdav_snapshot_get_content_length
+						(GDavSnapshot *snapshot,
+						 guint index);
+gint64		gdav_snapshot_get_last_modified	(GDavSnapshot *snapshot,
+						 guint index);
+GDavResourceType
+		gdav_snapshot_get_resource_type	(GDavSnapshot *snapshot,
+						 guint index);
+gboolean	gdav_snapshot_diff		(GDavSnapshot *snapshot,
+						 GDavListing *listing,
+						 GDavSnapshotDiffFunc func,
+						 gpointer user_data);
+
+G_END_DECLS
+
+#endif /* __GDAV_SNAPSHOT_H__ */
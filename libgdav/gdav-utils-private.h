@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_UTILS_PRIVATE_H__
+#define __GDAV_UTILS_PRIVATE_H__
+
+/* This is a private header, not installed. */
+
+#include "gdav-utils.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GDavResourceState GDavResourceState;
+
+/* What gdav_resource_state_changed() looks at. */
+struct _GDavResourceState {
+	GDavResourceType resource_type;
+	const gchar *etag;
+	guint64 content_length;
+	gint64 last_modified;
+};
+
+guint		gdav_href_hash			(gconstpointer path);
+gboolean	gdav_href_equal			(gconstpointer path_a,
+						 gconstpointer path_b);
+gint		gdav_href_compare		(const gchar *path_a,
+						 const gchar *path_b);
+gboolean	gdav_resource_state_changed	(const GDavResourceState *old_state,
+						 const GDavResourceState *new_state);
+
+G_END_DECLS
+
+#endif /* __GDAV_UTILS_PRIVATE_H__ */
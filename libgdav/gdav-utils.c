@@ -19,7 +19,10 @@
 
 #include "config.h"
 
+#include <string.h>
+
 #include "gdav-utils.h"
+#include "gdav-utils-private.h"
 
 struct _GDavAsyncClosure {
 	GMainLoop *loop;
@@ -27,14 +30,41 @@ struct _GDavAsyncClosure {
 	GAsyncResult *result;
 };
 
+static void	gdav_async_closure_destroy	(GDavAsyncClosure *closure);
+
+/* One idle closure per thread, kept around so back-to-back
+ * synchronous calls run on the same GMainContext.  libsoup
+ * ties connections to the context they were opened in, so
+ * a fresh context per call defeats keep-alive. */
+static GPrivate cached_closure =
+	G_PRIVATE_INIT ((GDestroyNotify) gdav_async_closure_destroy);
+
+static void
+gdav_async_closure_destroy (GDavAsyncClosure *closure)
+{
+	g_main_loop_unref (closure->loop);
+	g_main_context_unref (closure->context);
+
+	g_slice_free (GDavAsyncClosure, closure);
+}
+
 GDavAsyncClosure *
 gdav_async_closure_new (void)
 {
 	GDavAsyncClosure *closure;
 
-	closure = g_slice_new0 (GDavAsyncClosure);
-	closure->context = g_main_context_new ();
-	closure->loop = g_main_loop_new (closure->context, FALSE);
+	/* A nested synchronous call (say, from a callback
+	 * dispatched by an outer one) finds the cache empty
+	 * and gets a closure of its own. */
+	closure = g_private_get (&cached_closure);
+
+	if (closure != NULL) {
+		g_private_set (&cached_closure, NULL);
+	} else {
+		closure = g_slice_new0 (GDavAsyncClosure);
+		closure->context = g_main_context_new ();
+		closure->loop = g_main_loop_new (closure->context, FALSE);
+	}
 
 	g_main_context_push_thread_default (closure->context);
 
@@ -58,13 +88,15 @@ gdav_async_closure_free (GDavAsyncClosure *closure)
 
 	g_main_context_pop_thread_default (closure->context);
 
-	g_main_loop_unref (closure->loop);
-	g_main_context_unref (closure->context);
-
-	if (closure->result != NULL)
+	if (closure->result != NULL) {
 		g_object_unref (closure->result);
+		closure->result = NULL;
+	}
 
-	g_slice_free (GDavAsyncClosure, closure);
+	if (g_private_get (&cached_closure) == NULL)
+		g_private_set (&cached_closure, closure);
+	else
+		gdav_async_closure_destroy (closure);
 }
 
 void
@@ -195,3 +227,86 @@ gdav_options_from_headers (SoupMessageHeaders *headers)
 	return options;
 }
 
+
+/* Servers are inconsistent about trailing slashes on collection
+ * hrefs, so hash and compare paths as if they had none.  Use these
+ * wherever responses are matched up by path. */
+static gsize
+gdav_href_length (const gchar *path)
+{
+	gsize length = strlen (path);
+
+	while (length > 1 && path[length - 1] == '/')
+		length--;
+
+	return length;
+}
+
+guint
+gdav_href_hash (gconstpointer path)
+{
+	const gchar *cp = path;
+	gsize ii, length;
+	guint hash = 5381;
+
+	length = gdav_href_length (cp);
+
+	/* Same as g_str_hash(), up to the length. */
+	for (ii = 0; ii < length; ii++)
+		hash = (hash << 5) + hash + (guchar) cp[ii];
+
+	return hash;
+}
+
+gboolean
+gdav_href_equal (gconstpointer path_a,
+                 gconstpointer path_b)
+{
+	gsize length_a, length_b;
+
+	length_a = gdav_href_length (path_a);
+	length_b = gdav_href_length (path_b);
+
+	return (length_a == length_b) &&
+		(memcmp (path_a, path_b, length_a) == 0);
+}
+
+/* Orders paths consistently with gdav_href_equal(). */
+gint
+gdav_href_compare (const gchar *path_a,
+                   const gchar *path_b)
+{
+	gsize length_a, length_b;
+	gint cmp;
+
+	length_a = gdav_href_length (path_a);
+	length_b = gdav_href_length (path_b);
+
+	cmp = memcmp (path_a, path_b, MIN (length_a, length_b));
+
+	if (cmp == 0 && length_a != length_b)
+		cmp = (length_a < length_b) ? -1 : 1;
+
+	return cmp;
+}
+
+/* Decides whether a resource changed between two listings.  Both
+ * gdav_multi_status_diff() and GDavSnapshot go by this, so they
+ * always agree. */
+gboolean
+gdav_resource_state_changed (const GDavResourceState *old_state,
+                             const GDavResourceState *new_state)
+{
+	g_return_val_if_fail (old_state != NULL, FALSE);
+	g_return_val_if_fail (new_state != NULL, FALSE);
+
+	if (old_state->resource_type != new_state->resource_type)
+		return TRUE;
+
+	/* Entity tags are authoritative when the server gives them. */
+	if (old_state->etag != NULL || new_state->etag != NULL)
+		return (g_strcmp0 (old_state->etag, new_state->etag) != 0);
+
+	return (old_state->content_length != new_state->content_length) ||
+	       (old_state->last_modified != new_state->last_modified);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#include "config.h"
+
+#include "gdav-xml-tokens.h"
+
+#include <libxml/dict.h>
+
+struct _GDavXmlTokenizer {
+	const xmlChar *names[GDAV_XML_N_TOKENS];
+	const xmlChar *dav_href;
+};
+
+/* Indexed by GDavXmlToken.  GDAV_XML_TOKEN_OTHER has no name. */
+static const gchar *token_names[GDAV_XML_N_TOKENS] = {
+	NULL,
+	"error",
+	"href",
+	"location",
+	"prop",
+	"propstat",
+	"response",
+	"responsedescription",
+	"status",
+	"sync-token"
+};
+
+/* Tokenized nodes point their _private member into this array.
+ * That way we can tell our own marks apart from whatever else an
+ * application may have stored in a DOM it built itself. */
+static const guint8 token_marks[GDAV_XML_N_TOKENS];
+
+GDavXmlTokenizer *
+gdav_xml_tokenizer_new (xmlDict *dict)
+{
+	GDavXmlTokenizer *tokenizer;
+	guint ii;
+
+	g_return_val_if_fail (dict != NULL, NULL);
+
+	tokenizer = g_slice_new0 (GDavXmlTokenizer);
+
+	/* Names interned in the parser's dictionary compare equal
+	 * by pointer to every element name the parser reports. */
+	for (ii = 1; ii < GDAV_XML_N_TOKENS; ii++) {
+		tokenizer->names[ii] = xmlDictLookup (
+			dict, BAD_CAST token_names[ii], -1);
+	}
+
+	tokenizer->dav_href = xmlDictLookup (
+		dict, BAD_CAST GDAV_XMLNS_DAV, -1);
+
+	return tokenizer;
+}
+
+void
+gdav_xml_tokenizer_free (GDavXmlTokenizer *tokenizer)
+{
+	if (tokenizer != NULL)
+		g_slice_free (GDavXmlTokenizer, tokenizer);
+}
+
+GDavXmlToken
+gdav_xml_tokenizer_lookup (GDavXmlTokenizer *tokenizer,
+                           const xmlChar *localname,
+                           const xmlChar *ns_href)
+{
+	guint ii;
+
+	g_return_val_if_fail (tokenizer != NULL, GDAV_XML_TOKEN_OTHER);
+
+	if (ns_href == NULL)
+		return GDAV_XML_TOKEN_OTHER;
+
+	/* The parser interns namespace hrefs in its dictionary, so
+	 * the pointer comparison nearly always settles it.  That is
+	 * not guaranteed though, so fall back to comparing strings.
+	 * Any other namespace differs from "DAV:" within a few bytes. */
+	if (ns_href != tokenizer->dav_href &&
+	    xmlStrcmp (ns_href, BAD_CAST GDAV_XMLNS_DAV) != 0)
+		return GDAV_XML_TOKEN_OTHER;
+
+	for (ii = 1; ii < GDAV_XML_N_TOKENS; ii++) {
+		if (localname == tokenizer->names[ii])
+			return (GDavXmlToken) ii;
+	}
+
+	return GDAV_XML_TOKEN_OTHER;
+}
+
+GDavXmlToken
+gdav_xml_node_get_token (xmlNode *node)
+{
+	guintptr mark;
+	guint ii;
+
+	g_return_val_if_fail (node != NULL, GDAV_XML_TOKEN_OTHER);
+
+	mark = (guintptr) node->_private;
+
+	if (mark >= (guintptr) &token_marks[0] &&
+	    mark < (guintptr) &token_marks[GDAV_XML_N_TOKENS])
+		return (GDavXmlToken) (mark - (guintptr) &token_marks[0]);
+
+	/* The node was not tokenized while parsing,
+	 * so fall back to comparing strings. */
+
+	if (!gdav_is_xmlns (node, GDAV_XMLNS_DAV))
+		return GDAV_XML_TOKEN_OTHER;
+
+	for (ii = 1; ii < GDAV_XML_N_TOKENS; ii++) {
+		if (xmlStrcmp (node->name, BAD_CAST token_names[ii]) == 0)
+			return (GDavXmlToken) ii;
+	}
+
+	return GDAV_XML_TOKEN_OTHER;
+}
+
+void
+gdav_xml_node_set_token (xmlNode *node,
+                         GDavXmlToken token)
+{
+	g_return_if_fail (node != NULL);
+	g_return_if_fail (token < GDAV_XML_N_TOKENS);
+
+	node->_private = (gpointer) &token_marks[token];
+}
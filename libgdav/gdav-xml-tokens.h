@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+#ifndef __GDAV_XML_TOKENS_H__
+#define __GDAV_XML_TOKENS_H__
+
+/* This is a private header, not installed. */
+
+#include <libgdav/gdav-xml-namespaces.h>
+
+G_BEGIN_DECLS
+
+/* Small integer tokens for the DAV elements the container
+ * deserializers dispatch on.  GDAV_XML_TOKEN_OTHER covers
+ * everything else, including other namespaces. */
+typedef enum {
+	GDAV_XML_TOKEN_OTHER,
+	GDAV_XML_TOKEN_DAV_ERROR,
+	GDAV_XML_TOKEN_DAV_HREF,
+	GDAV_XML_TOKEN_DAV_LOCATION,
+	GDAV_XML_TOKEN_DAV_PROP,
+	GDAV_XML_TOKEN_DAV_PROPSTAT,
+	GDAV_XML_TOKEN_DAV_RESPONSE,
+	GDAV_XML_TOKEN_DAV_RESPONSEDESCRIPTION,
+	GDAV_XML_TOKEN_DAV_STATUS,
+	GDAV_XML_TOKEN_DAV_SYNC_TOKEN,
+	GDAV_XML_N_TOKENS
+} GDavXmlToken;
+
+typedef struct _GDavXmlTokenizer GDavXmlTokenizer;
+
+GDavXmlTokenizer *
+		gdav_xml_tokenizer_new		(xmlDict *dict);
+void		gdav_xml_tokenizer_free		(GDavXmlTokenizer *tokenizer);
+GDavXmlToken	gdav_xml_tokenizer_lookup	(GDavXmlTokenizer *tokenizer,
+						 const xmlChar *localname,
+						 const xmlChar *ns_href);
+GDavXmlToken	gdav_xml_node_get_token		(xmlNode *node);
+void		gdav_xml_node_set_token		(xmlNode *node,
+						 GDavXmlToken token);
+
+G_END_DECLS
+
+#endif /* __GDAV_XML_TOKENS_H__ */
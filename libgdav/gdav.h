@@ -25,7 +25,10 @@
 #include <libgdav/gdav-xml-namespaces.h>
 
 #include <libgdav/gdav-active-lock.h>
+#include <libgdav/gdav-batch.h>
+#include <libgdav/gdav-cache.h>
 #include <libgdav/gdav-error.h>
+#include <libgdav/gdav-listing.h>
 #include <libgdav/gdav-lock-entry.h>
 #include <libgdav/gdav-methods.h>
 #include <libgdav/gdav-multi-status.h>
@@ -36,6 +39,7 @@
 #include <libgdav/gdav-property-update.h>
 #include <libgdav/gdav-requests.h>
 #include <libgdav/gdav-response.h>
+#include <libgdav/gdav-snapshot.h>
 #include <libgdav/gdav-utils.h>
 
 /* DAV Properties */
@@ -51,6 +55,7 @@
 #include <libgdav/gdav-supportedlock-property.h>
 
 /* CalDAV Properties */
+#include <libgdav/gdav-calendar-data-property.h>
 #include <libgdav/gdav-calendar-description-property.h>
 #include <libgdav/gdav-calendar-timezone-property.h>
 #include <libgdav/gdav-max-resource-size-property.h>
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the licence, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, see <http://www.gnu.org/licenses/>.
+ *
+ * Author: Matthew Barnes <mbarnes@redhat.com>
+ */
+
+/* Times back-to-back synchronous PROPFIND requests and counts how many
+ * TCP connections they took, to check that gdav_*_sync() calls made in
+ * a loop reuse keep-alive connections.  With --new-thread each request
+ * runs in a thread of its own, which gets a fresh main context just as
+ * every sync call did before contexts were cached per thread. */
+
+#include "config.h"
+
+#include <locale.h>
+#include <stdlib.h>
+
+#include <libgdav/gdav.h>
+
+#define PARAMETER_STRING	"http://hostname[:port]/path"
+
+static gint opt_count = 100;
+static gboolean opt_new_thread;
+static gchar **opt_remaining;
+
+static GOptionEntry options[] = {
+	{ "count", 'n', 0,
+	  G_OPTION_ARG_INT, &opt_count,
+	  "Number of requests to send (default: 100)", "N" },
+	{ "new-thread", 't', 0,
+	  G_OPTION_ARG_NONE, &opt_new_thread,
+	  "Send each request from a new thread", NULL },
+	{ G_OPTION_REMAINING, 0, 0,
+	  G_OPTION_ARG_STRING_ARRAY, &opt_remaining, NULL, NULL },
+
+	{ NULL }
+};
+
+typedef struct {
+	SoupSession *session;
+	SoupURI *uri;
+	GError *error;
+} BenchRequest;
+
+static void
+request_started_cb (SoupSession *session,
+                    SoupMessage *message,
+                    SoupSocket *socket,
+                    GHashTable *local_ports)
+{
+	SoupAddress *address;
+
+	/* Every new connection gets a new local port. */
+	address = soup_socket_get_local_address (socket);
+
+	if (address != NULL)
+		g_hash_table_add (
+			local_ports, GUINT_TO_POINTER (
+			soup_address_get_port (address)));
+}
+
+static gpointer
+bench_request_run (gpointer data)
+{
+	BenchRequest *request = data;
+	GDavMultiStatus *multi_status;
+
+	multi_status = gdav_propfind_sync (
+		request->session, request->uri,
+		GDAV_PROPFIND_PROPNAME, NULL, GDAV_DEPTH_0,
+		NULL, NULL, &request->error);
+
+	g_clear_object (&multi_status);
+
+	return NULL;
+}
+
+gint
+main (gint argc,
+      gchar **argv)
+{
+	GOptionContext *context;
+	GHashTable *local_ports;
+	BenchRequest request;
+	GTimer *timer;
+	gdouble elapsed;
+	gint ii;
+	GError *local_error = NULL;
+
+	setlocale (LC_ALL, "");
+
+	context = g_option_context_new (PARAMETER_STRING);
+	g_option_context_add_main_entries (context, options, NULL);
+
+	if (!g_option_context_parse (context, &argc, &argv, &local_error)) {
+		g_printerr ("%s: %s\n", g_get_prgname (), local_error->message);
+		exit (-1);
+	}
+
+	g_option_context_free (context);
+
+	if (opt_remaining == NULL || opt_count <= 0) {
+		g_printerr ("Usage: %s [OPTION...] %s\n",
+			g_get_prgname (), PARAMETER_STRING);
+		exit (-1);
+	}
+
+	request.uri = soup_uri_new (opt_remaining[0]);
+	request.error = NULL;
+
+	if (request.uri == NULL) {
+		g_printerr ("Invalid URI: %s\n", opt_remaining[0]);
+		exit (-1);
+	}
+
+	request.session = soup_session_new ();
+	local_ports = g_hash_table_new (NULL, NULL);
+
+	g_signal_connect (
+		request.session, "request-started",
+		G_CALLBACK (request_started_cb), local_ports);
+
+	timer = g_timer_new ();
+
+	for (ii = 0; ii < opt_count && request.error == NULL; ii++) {
+		if (opt_new_thread)
+			g_thread_join (g_thread_new (
+				"bench-sync", bench_request_run, &request));
+		else
+			bench_request_run (&request);
+	}
+
+	elapsed = g_timer_elapsed (timer, NULL);
+
+	if (request.error != NULL) {
+		g_printerr (
+			"Request %d failed: %s\n",
+			ii, request.error->message);
+		exit (-1);
+	}
+
+	g_print (
+		"%d requests in %.3f s (%.2f ms each), %u connections\n",
+		opt_count, elapsed, elapsed * 1000.0 / opt_count,
+		g_hash_table_size (local_ports));
+
+	g_timer_destroy (timer);
+	g_hash_table_destroy (local_ports);
+	g_object_unref (request.session);
+	soup_uri_free (request.uri);
+
+	return 0;
+}
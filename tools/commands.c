@@ -77,6 +77,35 @@ handle_put (GlobalState *state,
             gint argc,
             const gchar **argv)
 {
+	SoupURI *uri;
+	GFile *file;
+	gchar *remote_path;
+	GError *local_error = NULL;
+
+	if (argc > 1)
+		remote_path = g_strdup (argv[1]);
+	else
+		remote_path = g_path_get_basename (argv[0]);
+
+	uri = soup_uri_new_with_base (state->base_uri, remote_path);
+
+	file = g_file_new_for_path (argv[0]);
+
+	g_print (_("Uploading %s to '%s'\n"), argv[0], uri->path);
+
+	/* The file is streamed from disk, not held in memory. */
+	gdav_put_file_sync (
+		state->session, uri, file, NULL, NULL,
+		GDAV_PUT_FLAGS_NONE, NULL, NULL, NULL, &local_error);
+
+	if (local_error != NULL) {
+		print_error (local_error);
+		g_error_free (local_error);
+	}
+
+	g_object_unref (file);
+	g_free (remote_path);
+	soup_uri_free (uri);
 }
 
 static void
@@ -84,6 +113,36 @@ handle_get (GlobalState *state,
             gint argc,
             const gchar **argv)
 {
+	SoupURI *uri;
+	GFile *file;
+	gchar *local_path;
+	GError *local_error = NULL;
+
+	uri = soup_uri_new_with_base (state->base_uri, argv[0]);
+
+	if (argc > 1)
+		local_path = g_strdup (argv[1]);
+	else
+		local_path = g_path_get_basename (argv[0]);
+
+	file = g_file_new_for_path (local_path);
+
+	g_print (_("Downloading '%s' to %s\n"), uri->path, local_path);
+
+	/* The body is streamed to disk, not held in memory, and
+	 * an interrupted download continues where it left off. */
+	gdav_get_resume_sync (
+		state->session, uri, file, NULL,
+		NULL, NULL, &local_error);
+
+	if (local_error != NULL) {
+		print_error (local_error);
+		g_error_free (local_error);
+	}
+
+	g_object_unref (file);
+	g_free (local_path);
+	soup_uri_free (uri);
 }
 
 static void